@@ -32,25 +32,35 @@
 
 #include "Arduino.h"
 #include "Protractor.h"
+#include "ProtractorProfile.h"
 
 Protractor::Protractor()
 {
+  _transport = 0;
+  _received = 0;
+  _pending = 0;
+  _onRead = 0;
 }
 
 // Initialize the Protractor with Serial communication
 void Protractor::begin(Stream &serial)
 {
-  _serial = &serial;
-  _comm = SERIALCOMM;
+  _streamTransport.begin(serial);
+  begin(_streamTransport);
 }
 
 // Initialize the Protractor with I2C communication
 void Protractor::begin(TwoWire &wire, int16_t address) 
+{
+  _wireTransport.begin(wire);
+  begin(_wireTransport,address);
+}
+
+// Initialize the Protractor with any other link, such as ProtractorUART or ProtractorRS485Transport
+void Protractor::begin(ProtractorTransport &transport, int16_t address)
 {
   _address = address;
-  _wire = &wire;
-  _wire->begin();
-  _comm = I2CCOMM;
+  _transport = &transport;
 }
 
 /////// BASIC FUNCTIONS ///////
@@ -63,99 +73,76 @@ bool Protractor::read() {
 // gets obs number of objects and obs number of paths from protractor. 
 // Returns the most visible objects and most open pathways. Minimizes data transfer for time sensitive applications.
 bool Protractor::read(int16_t obs) { 
-  if(obs > MAXOBJECTS) obs = MAXOBJECTS;
-  _numdata = obs;
-  uint8_t numBytes = 1 + obs*4;
-  _requestData(numBytes); // Request bytes from the obstacle sensor
-  int i = 0;
-  unsigned long startTime = micros();
-  unsigned long duration = 0;
-  unsigned long maxWait = 20000; // Wait no longer than this many micro-seconds for the next byte to arrive
-  while(i < numBytes && duration < maxWait){
-	if(_available()) {
-		_buffer[i] = _read(); 
-		i++;
-		startTime = micros();
-	}
-	duration =  micros() - startTime;
-  }
-  if(i == 0){
+  if(!startRead(obs)) return 0; // Request bytes from the obstacle sensor
+  while(!readComplete()); // Waits no longer than 20 milli-seconds for the next byte to arrive
+  _pending = 0;
+  if(_received == 0){
 	  return 0;
   } else {
 	  return 1;
   }
 }
 
-// returns the number of objects detected
-int16_t Protractor::objectCount() { 
-  return (int16_t)(_buffer[0] >> 4); // number of objects detected is the high nibble of _buffer[0]
-}
-
-// returns the number of paths detected
-int16_t Protractor::pathCount() { 
-  return (int16_t)(_buffer[0] &= 0b00001111); // number of paths detected is the low nibble of _buffer[0]
-}
-
-// returns the angle to the most visible object
-int16_t Protractor::objectAngle() { 
-  return objectAngle(0);
+// Starts reading obs objects and paths without waiting for them.
+// With ProtractorUART the frame is stored by an interrupt while the sketch carries on. Wire reads it right away.
+bool Protractor::startRead(int16_t obs) {
+  if(!_transport) return 0;
+  if(obs > MAXOBJECTS) obs = MAXOBJECTS;
+  _numdata = obs;
+  _received = 0;
+  if(!_transport->startRead(_address,_frame.data,1 + obs*4)) return 0;
+  _pending = 1;
+  _progressTime = micros();
+  return 1;
 }
 
-// returns the angle to the object ob in the object list, indexed from 1. 
-// Left most object is 1. If ob exceeds number of objects detected, return zero.
-int16_t Protractor::objectAngle(int16_t ob) { 
-  if(ob >= objectCount() || ob < 0){
-    return -1;
-  }else{
-    int16_t angle = map(_buffer[1+4*ob],0,255,0,180);  // ob0->_buffer[1], ob1->_buffer[5], etc.
-    return angle;
+// returns true once the read started by startRead() has finished.
+// Gives up on a read if no byte arrives for 20 milli-seconds.
+bool Protractor::readComplete() {
+  if(!_transport) return 1;
+  uint8_t numBytes = 1 + _numdata*4;
+  bool busy = _transport->busy(); // Checked first, so that bytes arriving in between are picked up by the next call
+  uint8_t received = _transport->receive(_frame.data,_received,numBytes);
+  if(received < numBytes && busy){
+    if(received != _received){
+      _received = received;
+      _progressTime = micros();
+      return 0;
+    }
+    if(micros() - _progressTime < READTIMEOUT) return 0; // Wait no longer than this for the next byte to arrive
+    _transport->abort();
   }
+  _received = received;
+  return 1;
 }
 
-// returns the visibility of the most visible object
-int16_t Protractor::objectVisibility() { 
-  return objectVisibility(0);
+// Sets a function for update() to call each time a read started by startRead() finishes
+void Protractor::onReadComplete(void (*callback)(Protractor &protractor)) {
+  _onRead = callback;
 }
 
-// returns the visibility of the object ob in the object list, indexed from 1.
-// Left most object is 1. If ob exceeds number of objects detected, return zero.
-int16_t Protractor::objectVisibility(int16_t ob = 0) { 
-  if(ob >= objectCount() || ob < 0){
-    return -1;
-  }else{
-    int16_t vis = _buffer[2+4*ob];  // ob0->_buffer[2], ob1->_buffer[6], etc.
-    return vis;
+// Call from the loop. Runs the onReadComplete() callback once the pending read has finished.
+void Protractor::update() {
+  if(_pending && readComplete()){
+    _pending = 0;
+    if(_onRead) _onRead(*this);
   }
 }
 
-// returns the angle to the most open pathway
-int16_t Protractor::pathAngle() { 
-  return pathAngle(0);
-}
-
-// returns the angle to the path pa in the pathway list, indexed from 1.
-// Left most path is 1. If pa exceeds number of pathways detected, return zero.
-int16_t Protractor::pathAngle(int16_t pa) { 
-  if(pa >= pathCount() || pa < 0){
-    return -1;
-  }else{
-    int16_t angle = map(_buffer[3+4*pa],0,255,0,180);  // pa0->_buffer[3], pa1->_buffer[7], etc.
-    return angle;
+// A frame from a single Protractor reports at most MAXOBJECTS objects and paths, ranked by decreasing visibility.
+// Bits flipped on a marginal bus, or two sensors answering on the same address, rarely keep that ranking.
+bool Protractor::validFrame(const uint8_t frame[], uint8_t length) {
+  if(length < 1+4*MAXOBJECTS) return false;
+  uint8_t objects = frame[0] >> 4;
+  uint8_t paths = frame[0] & 0b00001111;
+  if(objects > MAXOBJECTS || paths > MAXOBJECTS) return false;
+  for(uint8_t i = 1; i < objects; i++){
+    if(frame[2+4*i] > frame[2+4*(i-1)]) return false; // ob0->frame[2], ob1->frame[6], etc.
   }
-}
-int16_t Protractor::pathVisibility() {
-  return pathVisibility(0);
-}
-
-// returns the angle to the path pa in the pathway list, indexed from 1.
-// Left most path is 1. If pa exceeds number of pathways detected, return zero.
-int16_t Protractor::pathVisibility(int16_t pa) { 
-  if(pa >= pathCount() || pa < 0){
-    return -1;
-  }else{
-    int16_t vis = _buffer[4+4*pa];  // pa0->_buffer[4], pa1->_buffer[8], etc.
-    return vis;
+  for(uint8_t i = 1; i < paths; i++){
+    if(frame[4+4*i] > frame[4+4*(i-1)]) return false; // pa0->frame[4], pa1->frame[8], etc.
   }
+  return true;
 }
 
 /////// SETTINGS ///////
@@ -164,15 +151,27 @@ int16_t Protractor::pathVisibility(int16_t pa) {
 // 0 = scan only when called. 1 to 15 = rescan every 15ms, >15 = rescan every time_ms milliseconds.
 // Default time_ms is set to 15ms.
 void Protractor::scanTime(int16_t milliSeconds) {
-  if(milliSeconds >= 1 && milliSeconds <= MINDUR-1) {  // Values within 1 and 14 milliSeconds aren't allowed, the sensor requires a minimum 15 seconds to complete a scan.
-    uint8_t sendData[3] = {SCANTIME,MINDUR,'\n'};
-    _write(sendData,3); // Send a signal (char SCANTIME) to tell Protractor that it needs to change its time between scans to milliSeconds.
-  }else if(milliSeconds >= 0 && milliSeconds <= 32767) {  // Values less than 0 or greater than 32767 aren't allowed.
-    uint8_t sendData[4] = {SCANTIME,(byte)(milliSeconds & 0x00FF),(byte)(milliSeconds >> 8),'\n'};
-    _write(sendData,4); // Send a signal (char SCANTIME) to tell Protractor that it needs to change its time between scans to milliSeconds. 
+  uint8_t sendData[4];
+  uint8_t length = _scanTimeCommand(sendData,milliSeconds);
+  if(length > 0) {
+    _write(sendData,length); // Send a signal (char SCANTIME) to tell Protractor that it needs to change its time between scans to milliSeconds.
   }
 }
 
+// Start a scan now and keep its result for the next read. Only meant for scanTime(0).
+// Assumed, not confirmed with the firmware: asking for 0 bytes of data starts the scan without an answer, so
+// sensors on a shared bus can be triggered back to back. Left out when PROTRACTOR_TRIGGER is 0.
+bool Protractor::trigger() {
+#if PROTRACTOR_TRIGGER
+  if(!_transport) return 0;
+  uint8_t sendData[3] = {REQUESTDATA,0,'\n'};
+  _write(sendData,3);
+  return 1;
+#else
+  return 0;
+#endif
+}
+
 // change the I2C address. Will be stored after shutdown.
 // See manual for instructions on restoring defaults. Default address = 0x45 (69d).
 void Protractor::setNewI2Caddress(int16_t newAddress) { 
@@ -207,49 +206,86 @@ void Protractor::LEDoff() { // Turn off the feedback LEDs
   _write(sendData,3); // Send a signal (char LEDUSAGE) to tell Protractor that it needs to turn the feedback LEDOFF
 }
 
-/////// PRIVATE FUNCTIONS ///////
-
-uint8_t Protractor::_available() {
-  if(_comm == I2CCOMM){
-    return _wire->available();
-  }
-  else if(_comm == SERIALCOMM){
-    return _serial->available();
-  }
-  else{
-	return 0;
+// Apply the scan time and LED mode stored in a profile in a single pass.
+// Both settings are always sent, power-up defaults included. Over Serial, all commands go out in one write.
+bool Protractor::applyProfile(const ProtractorProfile &profile) {
+  if(!profile.valid() || !_transport) return 0;
+  // Every setting is sent, defaults included: a reset of the Arduino alone, such as a sketch upload,
+  // leaves the sensor running with whatever it was last told.
+  uint8_t sendData[7];
+  uint8_t length = _scanTimeCommand(sendData,profile.scanTime);
+  if(_transport->singleCommand()) { // The Protractor takes one command per I2C transaction
+    _write(sendData,length);
+    length = 0;
   }
+  sendData[length] = LEDUSAGE;
+  sendData[length+1] = profile.ledMode;
+  sendData[length+2] = '\n';
+  length += 3;
+  _write(sendData,length);
+  return 1;
 }
 
-uint8_t Protractor::_read() {
-  if(_comm == I2CCOMM){
-    return _wire->read();
-  }
-  else if(_comm == SERIALCOMM){
-    return _serial->read();
-  }
-  else{
-	return 0;
+/////// I2C CLOCK ///////
+
+// Standard I2C clock rates tried by negotiateClock() below maxClock, fastest first
+static const uint32_t clockRates[] = {1000000, 400000, 100000};
+#define CLOCKRATES (sizeof(clockRates)/sizeof(clockRates[0]))
+
+// Steps down from maxClock until a burst of full frames reads back valid.
+// A clock the sensor or the bus can not keep up with shows up as missing bytes or frames that break the ranking.
+uint32_t Protractor::negotiateClock(uint32_t maxClock, uint32_t *frameTime) {
+  if(frameTime) *frameTime = 0;
+  if(!_transport) return 0;
+  uint32_t clock = maxClock;
+  uint32_t slowest = 0;
+  uint8_t rate = 0;
+  while(true){
+    uint32_t time;
+    if(_transport->setClock(clock)){
+      slowest = clock;
+      if(_readsValid(time)){
+        if(frameTime) *frameTime = time;
+        return clock;
+      }
+    }
+    while(rate < CLOCKRATES && clockRates[rate] >= clock) rate++;
+    if(rate == CLOCKRATES) break;
+    clock = clockRates[rate];
   }
+  if(slowest) _transport->setClock(slowest);
+  return 0;
 }
 
+/////// PRIVATE FUNCTIONS ///////
+
 void Protractor::_write(uint8_t arrayBuffer[], uint8_t arrayLength) {
-  if(_comm == I2CCOMM){
-    _wire->beginTransmission(_address);
-    _wire->write(arrayBuffer,arrayLength);
-    _wire->endTransmission();
-  }
-  else if(_comm == SERIALCOMM){
-    _serial->write(arrayBuffer,arrayLength);
-  }
+  if(_transport) _transport->write(_address,arrayBuffer,arrayLength);
 }
 
-void Protractor::_requestData(uint8_t numBytes) {
-  if(_comm == I2CCOMM){
-    _wire->requestFrom(_address, numBytes);
+// Reads NEGOTIATEREADS full frames. Returns false at the first one that is short or not valid, otherwise the mean micro-seconds per frame in frameTime.
+bool Protractor::_readsValid(uint32_t &frameTime) {
+  unsigned long start = micros();
+  for(uint8_t i = 0; i < NEGOTIATEREADS; i++){
+    if(!read(MAXOBJECTS) || _received != 1+4*MAXOBJECTS || !validFrame(_frame.data,_received)) return 0;
   }
-  else if(_comm == SERIALCOMM) {
-    uint8_t sendData[3] = {REQUESTDATA,numBytes,'\n'};
-    _write(sendData,3); // Send a signal (char SENDDATA) to tell Protractor that it needs to send data, tell it the number of data points to send.
+  frameTime = (micros() - start) / NEGOTIATEREADS;
+  return 1;
+}
+
+// Fills sendData with the SCANTIME command for milliSeconds. Returns the length of the command, or 0 if milliSeconds is out of range.
+uint8_t Protractor::_scanTimeCommand(uint8_t sendData[], int16_t milliSeconds) {
+  if(milliSeconds >= 1 && milliSeconds <= MINDUR-1) {  // Values within 1 and 14 milliSeconds aren't allowed, the sensor requires a minimum 15 seconds to complete a scan.
+    sendData[0] = SCANTIME;
+    sendData[1] = MINDUR;
+    sendData[2] = '\n';
+    return 3;
+  }else if(milliSeconds >= 0 && milliSeconds <= 32767) {  // Values less than 0 or greater than 32767 aren't allowed.
+    sendData[0] = SCANTIME;
+    sendData[1] = (byte)(milliSeconds & 0x00FF);
+    sendData[2] = (byte)(milliSeconds >> 8);
+    sendData[3] = '\n';
+    return 4;
   }
+  return 0;
 }
@@ -33,17 +33,34 @@
 */
 
 //////////////////////BEGIN PROTRACTOR.H //////////////////////
+#ifndef Protractor_h
+#define Protractor_h
+
 #include <Wire.h>
 #include <inttypes.h>
+#include "ProtractorFrame.h"
+#include "ProtractorTransport.h"
+#include "ProtractorUART.h"
 	
 // Constants
 #define SERIALCOMM 1
 #define I2CCOMM  2
-#define MAXOBJECTS 4
 #define SHOWOBJ  1
 #define SHOWPATH 2
 #define LEDOFF   3
 #define MINDUR   15
+#define DEFAULTADDR 0x45
+#define NEGOTIATEREADS 16 // Full frames that must read back valid before negotiateClock() keeps a clock rate
+
+// trigger() relies on an ASSUMPTION that has not been confirmed against the Protractor firmware: that a
+// REQUESTDATA command for 0 data points starts a scan on a sensor set to scanTime(0) and keeps its result
+// for the next read. The user guide only says such a sensor scans when data is requested, and over I2C it
+// is the read that asks. Build with PROTRACTOR_TRIGGER defined as 0, as a compiler flag so the library's
+// own files see it too, to leave the command out: trigger() then sends nothing and returns false, and
+// ProtractorPoller.synchronize() keeps the sensors scanning on their own.
+#ifndef PROTRACTOR_TRIGGER
+#define PROTRACTOR_TRIGGER 1
+#endif
 
 // PROTRACTOR COMMANDS
 #define REQUESTDATA 0x15
@@ -52,39 +69,74 @@
 #define BAUDRATE 0x26
 #define LEDUSAGE 0x30
 
+class ProtractorProfile;
+
 class Protractor
 {
   public:
     Protractor();
     void begin(Stream &serial); // Initialize protractor using Serial
     void begin(TwoWire &wire, int16_t address); // Initialize protractor using I2C
+    void begin(ProtractorTransport &transport, int16_t address = 0); // Initialize protractor using any other link, such as ProtractorUART or ProtractorRS485Transport. The transport must already be started. address is the sensor's address on links that have one.
     bool read(); // gets all the data for all objects and paths from the protractor. Up to 4 objects and paths may be sensed at a time.
     bool read(int16_t obs); // gets only obs number of objects and obs number of paths from protractor. Returns the most visible objects and most open pathways first. Minimizes data transfer for time sensitive applications. If obs > 4 then obs = 4.
-    int16_t objectCount(); // returns the number of objects detected
-    int16_t pathCount(); // returns the number of paths detected
-    int16_t objectAngle(); // returns the angle to the most visible object
-    int16_t objectAngle(int16_t ob); // returns the angle to the object ob in the object list. Valid values of ob are 0 to 3. Object are ranked by intensity.  Most visible object is ob = 0.  Least visible object is ob = 3. If ob exceeds number of data points returned from sensor, returns -1.
-	int16_t objectVisibility(); // returns the visibility of the most visible object
-    int16_t objectVisibility(int16_t ob); // returns the visibility of the object ob in the object list. Valid values of ob are 0 to 3. Visibility is a relative measure of the amount of light reflected off an object. Visibility is generally not a good indicator of distance. If ob exceeds number of data points returned from sensor, returns -1.
-    int16_t pathAngle(); // returns the angle to the most open pathway
-    int16_t pathAngle(int16_t pa); // returns the angle to the path pa in the pathway list. Valid values of pa are 0 to 3. Pathways are ranked by openness.  Most open pathway is pa = 0.  Least open pathway is pa = 3. If pa exceeds number of data points returned from sensor, returns -1.
-	int16_t pathVisibility(); // returns the visibility of the most open pathway
-    int16_t pathVisibility(int16_t pa); // returns the visibility of a path pa in the path list. Valid values of pa are 0 to 3. Visibility is a relative measure of how little light is reflected from a pathway. Visibility can indicate which of several pathways is more open. If pa exceeds number of data points returned from sensor, returns -1.
+    bool startRead(int16_t obs = MAXOBJECTS); // Starts reading obs objects and paths without waiting for them. Returns false if the read could not be started. With ProtractorUART the frame arrives in the background; with Wire the read is done before it returns.
+    bool readComplete(); // returns true once the read started by startRead() has finished. Results must not be used before then.
+    void onReadComplete(void (*callback)(Protractor &protractor)); // Sets a function to be called by update() each time a read started by startRead() finishes, successfully or not
+    void update(); // Call from the loop when using startRead(). Calls the onReadComplete() function once the frame has arrived.
+    uint8_t frameLength() { return _received; } // returns the number of bytes received from the sensor during the most recent read, 0 if nothing was received. A full frame is 1+4*obs bytes.
+    static bool validFrame(const uint8_t frame[], uint8_t length); // returns true if frame holds a full frame of 1+4*MAXOBJECTS bytes as a single Protractor sends it: at most MAXOBJECTS objects and paths, ranked by decreasing visibility
+    const ProtractorFrame& frame() { return _frame; } // returns the most recent frame, with the same accessors as below
+    const uint8_t* frameData() { return _frame.data; } // returns the raw bytes received from the sensor during the most recent read. Byte 0 holds the object count (high nibble) and path count (low nibble), followed by 4 bytes per data point: object angle, object visibility, path angle, path visibility.
+    int16_t objectCount() { return _frame.objectCount(); } // returns the number of objects detected
+    int16_t pathCount() { return _frame.pathCount(); } // returns the number of paths detected
+    int16_t objectAngle() { return _frame.objectAngle(0); } // returns the angle to the most visible object
+    int16_t objectAngle(int16_t ob) { return _frame.objectAngle(ob); } // returns the angle to the object ob in the object list. Valid values of ob are 0 to 3. Object are ranked by intensity.  Most visible object is ob = 0.  Least visible object is ob = 3. If ob exceeds number of data points returned from sensor, returns -1.
+	int16_t objectVisibility() { return _frame.objectVisibility(0); } // returns the visibility of the most visible object
+    int16_t objectVisibility(int16_t ob) { return _frame.objectVisibility(ob); } // returns the visibility of the object ob in the object list. Valid values of ob are 0 to 3. Visibility is a relative measure of the amount of light reflected off an object. Visibility is generally not a good indicator of distance. If ob exceeds number of data points returned from sensor, returns -1.
+    int16_t pathAngle() { return _frame.pathAngle(0); } // returns the angle to the most open pathway
+    int16_t pathAngle(int16_t pa) { return _frame.pathAngle(pa); } // returns the angle to the path pa in the pathway list. Valid values of pa are 0 to 3. Pathways are ranked by openness.  Most open pathway is pa = 0.  Least open pathway is pa = 3. If pa exceeds number of data points returned from sensor, returns -1.
+	int16_t pathVisibility() { return _frame.pathVisibility(0); } // returns the visibility of the most open pathway
+    int16_t pathVisibility(int16_t pa) { return _frame.pathVisibility(pa); } // returns the visibility of a path pa in the path list. Valid values of pa are 0 to 3. Visibility is a relative measure of how little light is reflected from a pathway. Visibility can indicate which of several pathways is more open. If pa exceeds number of data points returned from sensor, returns -1.
+    uint32_t objectSectors() { return _frame.objectSectors(_received); } // returns a bit for each of the SECTORS sectors across the field of view, set if an object was received in it. Test a range with objectSectors() & ProtractorFrame::sectorMask(fromDegrees,toDegrees).
+    uint32_t pathSectors() { return _frame.pathSectors(_received); } // returns a bit for each of the SECTORS sectors across the field of view, set if a path was received in it
+    int16_t objectByAngle(int16_t i) { return _frame.objectByAngle(i,_received); } // returns the ob of the i-th object received counting up from 0 degrees, -1 if fewer were received. Use it with objectAngle(ob) and objectVisibility(ob).
+    int16_t pathByAngle(int16_t i) { return _frame.pathByAngle(i,_received); } // returns the pa of the i-th path received counting up from 0 degrees, -1 if fewer were received
+    int16_t nearestObjectTo(int16_t degrees) { return _frame.nearestObjectTo(degrees,_received); } // returns the ob of the object closest to degrees, -1 if none was received
+    int16_t nearestPathTo(int16_t degrees) { return _frame.nearestPathTo(degrees,_received); } // returns the pa of the path closest to degrees, -1 if none was received
+    int16_t objectAngleRaw(int16_t ob) { return _frame.objectAngleRaw(ob); } // returns the angle to object ob as sent by the sensor, 0 to 255 for 0 to 180 degrees, without the rounding of objectAngle(). If ob exceeds number of data points returned from sensor, returns -1.
+    int16_t pathAngleRaw(int16_t pa) { return _frame.pathAngleRaw(pa); } // returns the angle to path pa as sent by the sensor, 0 to 255 for 0 to 180 degrees. If pa exceeds number of data points returned from sensor, returns -1.
+    int16_t objectAngleQ7(int16_t ob) { return _frame.objectAngleQ7(ob); } // returns the angle to object ob in 128ths of a degree, 0 to 23040. If ob exceeds number of data points returned from sensor, returns -1.
+    int16_t pathAngleQ7(int16_t pa) { return _frame.pathAngleQ7(pa); } // returns the angle to path pa in 128ths of a degree, 0 to 23040. If pa exceeds number of data points returned from sensor, returns -1.
+    int16_t objectBearing(int16_t ob) { return _frame.objectBearing(ob); } // returns the angle to object ob at full resolution in Q15 half turns, 0 to 32767 for 0 to 180 degrees. If ob exceeds number of data points returned from sensor, returns -1.
+    int16_t pathBearing(int16_t pa) { return _frame.pathBearing(pa); } // returns the angle to path pa in Q15 half turns, 0 to 32767 for 0 to 180 degrees. If pa exceeds number of data points returned from sensor, returns -1.
+    int16_t objectVectorX(int16_t ob) { return _frame.objectVectorX(ob); } // returns cos(angle to object ob) in Q15, from a table. 0 if ob exceeds number of data points returned from sensor.
+    int16_t objectVectorY(int16_t ob) { return _frame.objectVectorY(ob); } // returns sin(angle to object ob) in Q15, from a table. 0 if ob exceeds number of data points returned from sensor.
+    int16_t pathVectorX(int16_t pa) { return _frame.pathVectorX(pa); } // returns cos(angle to path pa) in Q15, from a table. 0 if pa exceeds number of data points returned from sensor.
+    int16_t pathVectorY(int16_t pa) { return _frame.pathVectorY(pa); } // returns sin(angle to path pa) in Q15, from a table. 0 if pa exceeds number of data points returned from sensor.
     void LEDshowObject(); // Set the feedback LEDs to follow the most visible Objects detected
     void LEDshowPath(); // Set the feedback LEDs to follow the most open pathway detected
     void LEDoff(); // Turn off the feedback LEDs
+    bool trigger(); // For sensors set to scanTime(0). Starts a scan without waiting for its result, which is returned by the next read. Sent to a broadcast address, triggers every sensor at once. Assumed firmware behaviour, see PROTRACTOR_TRIGGER. Returns false if PROTRACTOR_TRIGGER is 0 or there is no link.
     void scanTime(int16_t milliSeconds); // 0 = scan only when called. 1 to 15 = rescan every 15ms, >15 = rescan every milliSeconds, max 32767.  Default time_ms is set to 15ms.
     void setNewI2Caddress(int16_t newAddress); // Change the I2C address. Will be remembered after Protractor shutdown. Protractor must be reset to take effect. See manual for instructions on restoring defaults. Default = 0x45 (69d).
     void setNewSerialBaudRate(int32_t baudRate); // Change the Serial Bus baud rate. Will be remembered after Protractor shutdown. Protractor must be reset to take effect. See manual for instructions on restoring defaults. Default = 9600 baud.
+    uint32_t negotiateClock(uint32_t maxClock = 400000, uint32_t *frameTime = 0); // I2C only. Finds the fastest clock up to maxClock Hz at which NEGOTIATEREADS full frames in a row read back valid, trying maxClock, then 1MHz, 400kHz and 100kHz below it. Returns the clock chosen and stores the mean micro-seconds per full frame in frameTime. Returns 0 if the link has no clock or no rate worked, leaving the slowest rate tried.
+    bool applyProfile(const ProtractorProfile &profile); // Sends the scan time and LED mode stored in profile in a single pass. Both are always sent, as the sensor may still hold settings from before the Arduino was reset. Returns false if the profile holds invalid settings.
   private:
-    uint8_t _read();
     void _write(uint8_t arrayBuffer[], uint8_t arrayLength);
-    uint8_t _available();
-    void _requestData(uint8_t numBytes);
-    uint8_t _buffer[1+4*MAXOBJECTS]; // store data received from Protractor.
+    uint8_t _scanTimeCommand(uint8_t sendData[], int16_t milliSeconds);
+    bool _readsValid(uint32_t &frameTime);
+    ProtractorFrame _frame; // store data received from Protractor. The accessors above decode it inline.
     uint8_t _address; // Stores the I2C bus address when communicating over I2C
     uint8_t _numdata; // Number of data points requested from sensor during most recent read
-    uint8_t _comm; // Tracks whether we are using I2C or Serial for communication
-    Stream* _serial; // Handle for the Serial object. May be a HW or SW serial.
-    TwoWire* _wire; // Handle for the TwoWire object (i2c). Allows usage of boards with multiple Wire ports.
+    uint8_t _received; // Number of bytes received from sensor during most recent read
+    ProtractorTransport* _transport; // Link to the sensor
+    ProtractorStreamTransport _streamTransport; // Used by begin(Stream)
+    ProtractorWireTransport _wireTransport; // Used by begin(TwoWire,address)
+    bool _pending; // A read started by startRead() has not been reported by update() yet
+    unsigned long _progressTime; // micros() when the running read last made progress
+    void (*_onRead)(Protractor &protractor); // Called by update() when a read finishes
 };
+
+#endif
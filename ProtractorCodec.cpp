@@ -0,0 +1,153 @@
+/*
+  ProtractorCodec.cpp - Delta compression of Protractor frames
+  Copyright (c) 2017 William Moore.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "Arduino.h"
+#include "ProtractorCodec.h"
+
+/////// ENCODER ///////
+
+ProtractorFrameEncoder::ProtractorFrameEncoder(uint8_t keyframeInterval)
+{
+  _interval = keyframeInterval > 16 || keyframeInterval == 0 ? 16 : keyframeInterval; // The packet counter only tells 16 packets apart
+  reset();
+}
+
+// Makes the next packet a keyframe
+void ProtractorFrameEncoder::reset() {
+  _length = 0;
+  _count = 0;
+}
+
+// Encodes the most recent frame read by protractor
+uint8_t ProtractorFrameEncoder::encode(Protractor &protractor, uint8_t packet[]) {
+  return encode(protractor.frameData(),protractor.frameLength(),packet);
+}
+
+// Encodes length bytes of frame into packet. The delta is built straight into packet and abandoned for a
+// keyframe as soon as it stops being smaller, so no scratch space beyond packet is needed.
+uint8_t ProtractorFrameEncoder::encode(const uint8_t frame[], uint8_t length, uint8_t packet[]) {
+  if(length > 1+4*MAXOBJECTS) length = 1+4*MAXOBJECTS;
+  if(length == 0){
+    packet[0] = CODECEMPTY;
+    return 1;
+  }
+  if(length != _length || _count+1 >= _interval) return _keyframe(frame,length,packet);
+
+  uint8_t size = 1;
+  packet[0] = (_count+1) & 0x0F;
+  if(frame[0] != _previous[0]){
+    packet[0] |= CODECHEADER;
+    packet[size++] = frame[0];
+  }
+  uint8_t maskAt = size;
+  uint16_t mask = 0;
+  size += 2;
+  for(uint8_t i = 1; i < length; i++){
+    int8_t change = (int8_t)(frame[i] - _previous[i]);
+    if(change == 0) continue;
+    uint8_t zigzag = (uint8_t)((uint8_t)change << 1) ^ (uint8_t)(change >> 7); // Shifted unsigned, as a left shift of a negative value is undefined
+    if(size + (zigzag < 0x80 ? 1 : 2) >= 1+length) return _keyframe(frame,length,packet); // No smaller than a keyframe
+    mask |= (uint16_t)1 << (i-1);
+    if(zigzag < 0x80){
+      packet[size++] = zigzag;
+    }else{
+      packet[size++] = zigzag | 0x80;
+      packet[size++] = zigzag >> 7;
+    }
+  }
+  if(size >= 1+length) return _keyframe(frame,length,packet); // A short frame's header and mask alone can outgrow it
+  packet[maskAt] = (uint8_t)mask;
+  packet[maskAt+1] = (uint8_t)(mask >> 8);
+  memcpy(_previous,frame,length);
+  _count++;
+  return size;
+}
+
+uint8_t ProtractorFrameEncoder::_keyframe(const uint8_t frame[], uint8_t length, uint8_t packet[]) {
+  packet[0] = CODECKEYFRAME | length;
+  memcpy(packet+1,frame,length);
+  memcpy(_previous,frame,length);
+  _length = length;
+  _count = 0;
+  return 1+length;
+}
+
+/////// DECODER ///////
+
+ProtractorFrameDecoder::ProtractorFrameDecoder()
+{
+  _length = 0;
+  _count = 0;
+}
+
+// returns true while deltas can be decoded
+bool ProtractorFrameDecoder::synced() {
+  return _length > 0;
+}
+
+// Rebuilds a frame from packet
+uint8_t ProtractorFrameDecoder::decode(const uint8_t packet[], uint8_t size, uint8_t frame[]) {
+  if(size == 0) return CODECERROR;
+  uint8_t type = packet[0];
+  if(type & CODECKEYFRAME){
+    uint8_t length = type & 0x3F;
+    if(length == 0 || length > 1+4*MAXOBJECTS || size != 1+length){
+      _length = 0;
+      return CODECERROR;
+    }
+    memcpy(_previous,packet+1,length);
+    _length = length;
+    _count = 0;
+  }else if(type == CODECEMPTY){
+    return 0;
+  }else{
+    if(_length == 0 || (type & 0x0F) != ((_count+1) & 0x0F) || (type & 0x50)){
+      _length = 0; // Lost a packet, or damaged. Wait for the next keyframe.
+      return CODECERROR;
+    }
+    uint8_t at = 1;
+    uint8_t header = _previous[0];
+    if(type & CODECHEADER){
+      if(at >= size) { _length = 0; return CODECERROR; }
+      header = packet[at++];
+    }
+    if(at+2 > size) { _length = 0; return CODECERROR; }
+    uint16_t mask = packet[at] | ((uint16_t)packet[at+1] << 8);
+    at += 2;
+    uint8_t next[1+4*MAXOBJECTS];
+    memcpy(next,_previous,_length);
+    next[0] = header;
+    for(uint8_t i = 1; i < _length; i++){
+      if(!(mask & ((uint16_t)1 << (i-1)))) continue;
+      if(at >= size) { _length = 0; return CODECERROR; }
+      uint8_t zigzag = packet[at++];
+      if(zigzag & 0x80){
+        if(at >= size) { _length = 0; return CODECERROR; }
+        zigzag = (zigzag & 0x7F) | (packet[at++] << 7);
+      }
+      int8_t change = (int8_t)((zigzag >> 1) ^ -(zigzag & 1));
+      next[i] = _previous[i] + change;
+    }
+    if(at != size || (mask >> (_length-1)) != 0) { _length = 0; return CODECERROR; }
+    memcpy(_previous,next,_length);
+    _count++;
+  }
+  memcpy(frame,_previous,_length);
+  return _length;
+}
@@ -0,0 +1,80 @@
+/*
+  ProtractorCodec.h - Delta compression of Protractor frames
+  Copyright (c) 2017 William Moore.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+  ###########################################################################
+
+  The Protractor scans 66 times a second and angles and visibilities change slowly, so consecutive frames
+  are mostly the same. The ProtractorFrameEncoder turns each frame into a packet that only holds what
+  changed since the previous frame, and the ProtractorFrameDecoder rebuilds the frames from the packets.
+  This is meant for radio links with little bandwidth and for fitting longer recordings on an SD card.
+
+  The first byte of every packet tells its type:
+    0b10LLLLLL  keyframe: the next L bytes are the whole frame
+    0b01000000  the sensor did not answer; the previous frame is kept as the reference
+    0b00H0SSSS  delta: S counts the packets since the last keyframe (mod 16), so a lost packet is noticed.
+                If H is set the next byte is the new count byte (frame byte 0). Then two bytes, low first,
+                mark which of frame bytes 1 to 16 changed, followed by the change of each marked byte as a
+                zig-zag varint (one byte for changes of -64 to 63, else two).
+
+  A keyframe is sent every keyframeInterval frames, whenever the frame length changes, and whenever a
+  delta would not be smaller than the keyframe. A packet is never longer than CODECMAXPACKET bytes, and
+  encoder and decoder each keep just the previous frame: 20 bytes of RAM.
+
+  ############################################################################
+*/
+
+#ifndef ProtractorCodec_h
+#define ProtractorCodec_h
+
+#include <inttypes.h>
+#include "Protractor.h"
+
+#define CODECMAXPACKET (2+4*MAXOBJECTS) // Largest packet: a keyframe of a full frame
+#define CODECKEYFRAME  0x80
+#define CODECEMPTY     0x40
+#define CODECHEADER    0x20 // Delta packet carries a new count byte
+#define CODECERROR     0xFF // Returned by decode() when a packet cannot be decoded
+
+class ProtractorFrameEncoder
+{
+  public:
+    ProtractorFrameEncoder(uint8_t keyframeInterval = 16);
+    uint8_t encode(const uint8_t frame[], uint8_t length, uint8_t packet[]); // Encodes length bytes of frame into packet[CODECMAXPACKET]. Returns the packet size.
+    uint8_t encode(Protractor &protractor, uint8_t packet[]); // Encodes the most recent frame read by protractor
+    void reset(); // Makes the next packet a keyframe, e.g. after the receiver reported a lost packet
+  private:
+    uint8_t _keyframe(const uint8_t frame[], uint8_t length, uint8_t packet[]);
+    uint8_t _previous[1+4*MAXOBJECTS]; // Reference frame
+    uint8_t _length; // Length of the reference frame, 0 before the first keyframe
+    uint8_t _count; // Packets since the last keyframe
+    uint8_t _interval; // Frames between keyframes
+};
+
+class ProtractorFrameDecoder
+{
+  public:
+    ProtractorFrameDecoder();
+    uint8_t decode(const uint8_t packet[], uint8_t size, uint8_t frame[]); // Rebuilds a frame into frame[1+4*MAXOBJECTS]. Returns the frame length, 0 if the sensor did not answer, or CODECERROR if the packet is damaged or follows a lost packet. Decoding resumes at the next keyframe.
+    bool synced(); // returns true while deltas can be decoded
+  private:
+    uint8_t _previous[1+4*MAXOBJECTS]; // Reference frame
+    uint8_t _length; // Length of the reference frame, 0 while not synced
+    uint8_t _count; // Packets since the last keyframe
+};
+
+#endif
@@ -0,0 +1,187 @@
+/*
+  ProtractorFilter.h - Fixed point filters for streams of Protractor readings
+  Copyright (c) 2017 William Moore.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+  ###########################################################################
+
+  Filters for one int16_t reading per frame, such as objectAngleQ7(0) or an accelerometer axis. Each size
+  is a template parameter, so a filter is a fixed block of memory with no new, malloc or float, and every
+  add() costs the same whatever the history:
+
+    ProtractorRunningSum<N>        mean of the last N readings
+    ProtractorEMA<SHIFT>           exponential moving average, weight 1/2^SHIFT on the newest reading
+    ProtractorMedian<N>            median of the last N readings, N odd, for dropping single spikes
+    ProtractorAlphaBeta<A,B>       position and rate tracker with gains 1/2^A and 1/2^B
+
+  Divisions are by constants. When N is a power of two, average() is a shift; any other N is a division
+  the compiler calls a routine for, an estimated several hundred cycles for 32 bits on an AVR. The gains of the EMA and
+  alpha-beta filters are powers of two for the same reason. Shifts of negative values round toward minus
+  infinity, where a division rounds toward zero, so results for negative readings can differ by 1.
+
+  extras/avrbench and extras/host/bench time add() and the result of each. The AVR suite has not been
+  run yet, so the AVR costs given here are estimates until its numbers are committed.
+
+  ############################################################################
+*/
+
+#ifndef ProtractorFilter_h
+#define ProtractorFilter_h
+
+#include <inttypes.h>
+
+#define FILTERFRACTIONBITS 8 // Fraction bits kept by ProtractorAlphaBeta between readings
+
+// Compile time helpers for sizes
+struct ProtractorFilterSize
+{
+  static constexpr bool isPowerOfTwo(uint8_t n) { return n != 0 && (n & (n - 1)) == 0; }
+  static constexpr uint8_t log2(uint8_t n) { return n <= 1 ? 0 : 1 + log2(n >> 1); }
+  static constexpr int32_t divide(int32_t value, uint8_t n) { return isPowerOfTwo(n) ? value >> log2(n) : value / n; } // value/n, a shift when n is a power of two
+};
+
+// Mean of the last N readings. Until N have been added, the mean of those added so far.
+template<uint8_t N>
+class ProtractorRunningSum
+{
+  static_assert(N >= 1, "a running sum needs at least one reading");
+  public:
+    ProtractorRunningSum() { clear(); }
+    void clear() { // Forgets every reading
+      _sum = 0;
+      _index = 0;
+      _count = 0;
+      for(uint8_t i = 0; i < N; i++) _readings[i] = 0;
+    }
+    void fill(int16_t value) { // Acts as if value had been added N times
+      for(uint8_t i = 0; i < N; i++) _readings[i] = value;
+      _sum = (int32_t)value * N;
+      _index = 0;
+      _count = N;
+    }
+    void add(int16_t value) {
+      _sum += (int32_t)value - _readings[_index]; // In 32 bits, a swing of more than 32767 would overflow an AVR int
+      _readings[_index] = value;
+      if(++_index == N) _index = 0;
+      if(_count < N) _count++;
+    }
+    int32_t sum() const { return _sum; } // returns the sum of the last N readings
+    uint8_t count() const { return _count; } // returns the number of readings held, up to N
+    int16_t average() const { // returns the mean, 0 if nothing was added
+      if(_count == N) return (int16_t)ProtractorFilterSize::divide(_sum, N);
+      return _count == 0 ? 0 : (int16_t)(_sum / _count); // Only while filling up
+    }
+  private:
+    int16_t _readings[N];
+    int32_t _sum;
+    uint8_t _index; // Where the next reading goes, over the oldest one
+    uint8_t _count;
+};
+
+// Exponential moving average: each reading moves the average 1/2^SHIFT of the way toward it.
+// The average is kept with SHIFT extra fraction bits, so small steps are not lost to rounding.
+template<uint8_t SHIFT>
+class ProtractorEMA
+{
+  static_assert(SHIFT >= 1 && SHIFT <= 15, "SHIFT must be 1 to 15");
+  public:
+    ProtractorEMA() { clear(); }
+    void clear() { _state = 0; _started = 0; } // The next reading starts the average
+    void fill(int16_t value) { _state = (int32_t)value << SHIFT; _started = 1; }
+    void add(int16_t value) {
+      if(!_started) {
+        fill(value);
+        return;
+      }
+      _state += value - (_state >> SHIFT);
+    }
+    int16_t average() const { return (int16_t)(_state >> SHIFT); }
+  private:
+    int32_t _state; // The average times 2^SHIFT
+    bool _started;
+};
+
+// Median of the last N readings, which ignores up to N/2 readings that jump away and back. Readings are
+// kept both in the order they came and sorted, so add() moves at most N values and median() is a load.
+// Until N have been added, the median of those added so far.
+template<uint8_t N>
+class ProtractorMedian
+{
+  static_assert(N % 2 == 1 && N <= 15, "N must be odd and at most 15");
+  public:
+    ProtractorMedian() { clear(); }
+    void clear() { _index = 0; _count = 0; }
+    void fill(int16_t value) { // Acts as if value had been added N times
+      for(uint8_t i = 0; i < N; i++) _readings[i] = _sorted[i] = value;
+      _index = 0;
+      _count = N;
+    }
+    void add(int16_t value) {
+      uint8_t i;
+      if(_count == N) { // Takes the oldest reading out of the sorted list
+        int16_t oldest = _readings[_index];
+        for(i = 0; _sorted[i] != oldest; i++);
+        for(; i < N - 1; i++) _sorted[i] = _sorted[i+1];
+      } else {
+        _count++;
+      }
+      for(i = _count - 1; i > 0 && _sorted[i-1] > value; i--) _sorted[i] = _sorted[i-1];
+      _sorted[i] = value;
+      _readings[_index] = value;
+      if(++_index == N) _index = 0;
+    }
+    uint8_t count() const { return _count; } // returns the number of readings held, up to N
+    int16_t median() const { return _count == 0 ? 0 : _sorted[(_count - 1) >> 1]; } // returns the median, the lower middle one of an even count, 0 if nothing was added
+  private:
+    int16_t _readings[N]; // In the order added
+    int16_t _sorted[N]; // The same readings, lowest first
+    uint8_t _index; // Where the next reading goes, over the oldest one
+    uint8_t _count;
+};
+
+// Tracks a reading and its rate of change per add(), such as an object's angle while the robot turns.
+// Each add() first moves the estimate on by the rate, then corrects the estimate by 1/2^A of the error
+// and the rate by 1/2^B of it. A of 1 to 3 and B of 3 to 6 suit readings every frame; a larger B
+// gives a steadier rate that is slower to follow a change. Values are kept with FILTERFRACTIONBITS
+// fraction bits.
+template<uint8_t A, uint8_t B>
+class ProtractorAlphaBeta
+{
+  static_assert(A <= 15 && B <= 15, "gains are 1/2^0 to 1/2^15");
+  public:
+    ProtractorAlphaBeta() { clear(); }
+    void clear() { _value = 0; _rate = 0; _started = 0; } // The next reading starts the track
+    void fill(int16_t value) { _value = (int32_t)value << FILTERFRACTIONBITS; _rate = 0; _started = 1; }
+    void add(int16_t value) {
+      if(!_started) {
+        fill(value);
+        return;
+      }
+      _value += _rate;
+      int32_t error = ((int32_t)value << FILTERFRACTIONBITS) - _value;
+      _value += error >> A;
+      _rate += error >> B;
+    }
+    int16_t value() const { return (int16_t)(_value >> FILTERFRACTIONBITS); } // returns the estimate
+    int16_t predict() const { return (int16_t)((_value + _rate) >> FILTERFRACTIONBITS); } // returns the estimate for the next add(), for when a frame is missed
+    int32_t rate() const { return _rate; } // returns the change per add() with FILTERFRACTIONBITS fraction bits
+  private:
+    int32_t _value;
+    int32_t _rate;
+    bool _started;
+};
+
+#endif
@@ -0,0 +1,41 @@
+/*
+  ProtractorFrame.cpp - Decodes a frame from the Protractor Sensor
+  Copyright (c) 2017 William Moore.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "ProtractorFrame.h"
+
+// sin(k*pi/510) in Q15 for k = 0 to 255, a quarter wave in half steps of an angle byte, rounded and capped at 32767.
+// Generated with: [min(32767, round(32768*math.sin(k*math.pi/510))) for k in range(256)]
+const int16_t protractorQuarterWave[256] PROTRACTOR_PROGMEM = {
+  0, 202, 404, 606, 807, 1009, 1211, 1413, 1614, 1816, 2017, 2219, 2420, 2621, 2822, 3023,
+  3224, 3425, 3626, 3826, 4027, 4227, 4427, 4627, 4827, 5026, 5226, 5425, 5624, 5823, 6021, 6219,
+  6417, 6615, 6813, 7010, 7207, 7404, 7600, 7797, 7993, 8188, 8383, 8578, 8773, 8967, 9161, 9355,
+  9548, 9741, 9934, 10126, 10318, 10509, 10700, 10891, 11081, 11271, 11460, 11649, 11837, 12025, 12213, 12400,
+  12586, 12773, 12958, 13143, 13328, 13512, 13696, 13879, 14061, 14243, 14425, 14606, 14786, 14966, 15145, 15324,
+  15502, 15680, 15857, 16033, 16209, 16384, 16558, 16732, 16906, 17078, 17250, 17421, 17592, 17762, 17931, 18100,
+  18268, 18435, 18602, 18767, 18932, 19097, 19261, 19423, 19586, 19747, 19908, 20068, 20227, 20385, 20543, 20700,
+  20856, 21011, 21166, 21319, 21472, 21624, 21776, 21926, 22076, 22224, 22372, 22519, 22666, 22811, 22955, 23099,
+  23242, 23384, 23525, 23665, 23804, 23942, 24079, 24216, 24351, 24486, 24620, 24752, 24884, 25015, 25145, 25274,
+  25402, 25529, 25655, 25780, 25904, 26027, 26149, 26271, 26391, 26510, 26628, 26745, 26861, 26976, 27090, 27203,
+  27315, 27426, 27536, 27645, 27753, 27860, 27966, 28070, 28174, 28276, 28378, 28478, 28578, 28676, 28773, 28869,
+  28964, 29058, 29151, 29242, 29333, 29422, 29510, 29598, 29684, 29769, 29852, 29935, 30017, 30097, 30176, 30254,
+  30331, 30407, 30482, 30555, 30628, 30699, 30769, 30838, 30905, 30972, 31037, 31101, 31164, 31226, 31287, 31346,
+  31404, 31461, 31517, 31572, 31625, 31677, 31728, 31778, 31827, 31874, 31921, 31966, 32009, 32052, 32093, 32133,
+  32172, 32210, 32247, 32282, 32316, 32349, 32380, 32411, 32440, 32468, 32494, 32520, 32544, 32567, 32588, 32609,
+  32628, 32646, 32663, 32679, 32693, 32706, 32718, 32728, 32738, 32746, 32752, 32758, 32762, 32766, 32767, 32767
+};
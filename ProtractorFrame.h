@@ -0,0 +1,219 @@
+/*
+  ProtractorFrame.h - Decodes a frame from the Protractor Sensor
+  Copyright (c) 2017 William Moore.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+  ###########################################################################
+
+  A frame is what the Protractor sends for each read: one byte with the object count (high nibble) and
+  the path count (low nibble), then 4 bytes per data point: object angle, object visibility, path angle
+  and path visibility. Angles are sent as 0 to 255 for 0 to 180 degrees.
+
+  Sketches call the accessors many times per frame, and Arduino builds are rarely linked with LTO, so
+  every accessor here is defined in the header. A call such as Protractor.objectVisibility(1) then
+  compiles down to a bounds check and a load from the frame. Reading frames is left to Protractor and
+  its ProtractorTransport; this header only decodes them and does not depend on the Arduino core.
+
+  The number of data points a frame holds is a template parameter, so a sketch that only ever reads the
+  most visible object and path keeps a 5 byte ProtractorFrameOf<1> instead of the full 17 byte frame.
+  Data points beyond it read as absent, whatever the counts in byte 0 say.
+
+  objectSectors() sorts the angles of the objects received into SECTORS sectors across the field of view,
+  one bit per sector, so that a question such as "is any object between 60 and 120 degrees?" is answered
+  by objectSectors(length) & sectorMask(60,120). With 32 sectors the sector of an angle byte is its top 5
+  bits, each sector 5.6 degrees wide.
+
+  The sensor ranks objects by visibility and paths by openness. objectByAngle(i) lists the slots received
+  in order of angle, from 0 to 180 degrees, with a fixed sorting network of five compare-exchanges, and
+  nearestObjectTo(heading) finds the closest one in a single pass.
+
+  These take the number of bytes received, so that slots which did not arrive are left out, and are
+  worked out on each call instead of being stored: a frame is its bytes and nothing else.
+
+  Steering by vectors needs the sine and cosine of each angle, which in float is estimated at thousands
+  of cycles on an AVR. objectVectorX(ob) and objectVectorY(ob) look them up instead, in Q15 (32767 is 1.0), from a
+  256 entry quarter wave table kept in flash by ProtractorFrame.cpp. x is cos(angle), 1.0 toward 0
+  degrees; y is sin(angle), 1.0 straight out from the sensor at 90 degrees. A missing object or path
+  gives the zero vector, so vectors can be summed over every slot without checking the counts.
+
+  objectAngle() rounds down to whole degrees, and 255 angle steps onto 181 degrees loses about a third of
+  the steps. objectAngleRaw() gives the angle byte as sent, and objectAngleQ7() degrees in 128ths, which
+  keeps every step distinct and still fits an int16_t for filtering and averaging.
+
+  ############################################################################
+*/
+
+#ifndef ProtractorFrame_h
+#define ProtractorFrame_h
+
+#include <inttypes.h>
+#ifdef __AVR__
+#include <avr/pgmspace.h>
+#define PROTRACTOR_PROGMEM PROGMEM
+#define PROTRACTOR_READWAVE(k) ((int16_t)pgm_read_word(&protractorQuarterWave[k]))
+#else
+#define PROTRACTOR_PROGMEM
+#define PROTRACTOR_READWAVE(k) (protractorQuarterWave[k])
+#endif
+
+#define MAXOBJECTS 4 // Data points in a full frame
+#define SECTORS 32 // Sectors of 180/32 = 5.6 degrees across the field of view, one bit each in a sector mask
+#define SECTORSHIFT 3 // An angle byte shifted right by this is its sector
+#define Q15ONE 32767 // 1.0 in Q15, the scale of unit vectors and bearings
+#define Q12PI 12868 // pi radians in Q12, the scale of toRadians()
+
+extern const int16_t protractorQuarterWave[256] PROTRACTOR_PROGMEM; // sin(k*pi/510) in Q15, defined in ProtractorFrame.cpp
+
+// The bytes of a frame of up to POINTS data points, and the accessors that decode them
+template<uint8_t POINTS>
+struct ProtractorFrameOf
+{
+  static_assert(POINTS >= 1 && POINTS <= MAXOBJECTS, "a frame holds 1 to MAXOBJECTS data points");
+  uint8_t data[1+4*POINTS]; // Raw bytes, as received from the sensor
+
+  // length is the number of bytes received, such as Protractor.frameLength()
+  uint8_t objectsReceived(uint8_t length) const { return received(objectCount(), length); } // Objects both reported and received
+  uint8_t pathsReceived(uint8_t length) const { return received(pathCount(), length); } // Paths both reported and received
+  uint32_t objectSectors(uint8_t length) const { return sectors(1, objectsReceived(length)); } // Bit s is set if a received object lies in sector s
+  uint32_t pathSectors(uint8_t length) const { return sectors(3, pathsReceived(length)); } // Bit s is set if a received path lies in sector s
+  int16_t objectByAngle(int16_t i, uint8_t length) const { return byAngle(1, objectsReceived(length), i); } // Slot of the i-th received object counting from 0 degrees, -1 if there are not that many
+  int16_t pathByAngle(int16_t i, uint8_t length) const { return byAngle(3, pathsReceived(length), i); } // Slot of the i-th received path counting from 0 degrees, -1 if there are not that many
+  int16_t nearestObjectTo(int16_t degrees, uint8_t length) const { return nearest(1, objectsReceived(length), degrees); } // Slot of the received object closest to degrees, -1 if none
+  int16_t nearestPathTo(int16_t degrees, uint8_t length) const { return nearest(3, pathsReceived(length), degrees); } // Slot of the received path closest to degrees, -1 if none
+
+  int16_t objectCount() const { return (int16_t)(data[0] >> 4); } // number of objects detected is the high nibble of data[0]
+  int16_t pathCount() const { return (int16_t)(data[0] & 0b00001111); } // number of paths detected is the low nibble of data[0]
+  int16_t objectAngle(int16_t ob) const { // ob0->data[1], ob1->data[5], etc. -1 if ob is not in the frame.
+    if(ob < 0 || ob >= POINTS || ob >= objectCount()) return -1;
+    return toDegrees(data[1+4*ob]);
+  }
+  int16_t objectVisibility(int16_t ob) const { // ob0->data[2], ob1->data[6], etc. -1 if ob is not in the frame.
+    if(ob < 0 || ob >= POINTS || ob >= objectCount()) return -1;
+    return data[2+4*ob];
+  }
+  int16_t pathAngle(int16_t pa) const { // pa0->data[3], pa1->data[7], etc. -1 if pa is not in the frame.
+    if(pa < 0 || pa >= POINTS || pa >= pathCount()) return -1;
+    return toDegrees(data[3+4*pa]);
+  }
+  int16_t pathVisibility(int16_t pa) const { // pa0->data[4], pa1->data[8], etc. -1 if pa is not in the frame.
+    if(pa < 0 || pa >= POINTS || pa >= pathCount()) return -1;
+    return data[4+4*pa];
+  }
+  int16_t objectAngleRaw(int16_t ob) const { // Angle to object ob as sent, 0 to 255 for 0 to 180 degrees. -1 if ob is not in the frame.
+    if(ob < 0 || ob >= POINTS || ob >= objectCount()) return -1;
+    return data[1+4*ob];
+  }
+  int16_t pathAngleRaw(int16_t pa) const { // Angle to path pa as sent, 0 to 255 for 0 to 180 degrees. -1 if pa is not in the frame.
+    if(pa < 0 || pa >= POINTS || pa >= pathCount()) return -1;
+    return data[3+4*pa];
+  }
+  int16_t objectAngleQ7(int16_t ob) const { // Angle to object ob in 128ths of a degree, 0 to 23040. -1 if ob is not in the frame.
+    if(ob < 0 || ob >= POINTS || ob >= objectCount()) return -1;
+    return toDegreesQ7(data[1+4*ob]);
+  }
+  int16_t pathAngleQ7(int16_t pa) const { // Angle to path pa in 128ths of a degree, 0 to 23040. -1 if pa is not in the frame.
+    if(pa < 0 || pa >= POINTS || pa >= pathCount()) return -1;
+    return toDegreesQ7(data[3+4*pa]);
+  }
+  int16_t objectBearing(int16_t ob) const { // Angle to object ob in Q15 half turns, 0 to Q15ONE for 0 to 180 degrees. -1 if ob is not in the frame.
+    if(ob < 0 || ob >= POINTS || ob >= objectCount()) return -1;
+    return toBearing(data[1+4*ob]);
+  }
+  int16_t pathBearing(int16_t pa) const { // Angle to path pa in Q15 half turns, 0 to Q15ONE for 0 to 180 degrees. -1 if pa is not in the frame.
+    if(pa < 0 || pa >= POINTS || pa >= pathCount()) return -1;
+    return toBearing(data[3+4*pa]);
+  }
+  int16_t objectVectorX(int16_t ob) const { return ob < 0 || ob >= POINTS || ob >= objectCount() ? 0 : cosQ15(data[1+4*ob]); } // cos of the angle to object ob in Q15, 0 if ob is not in the frame
+  int16_t objectVectorY(int16_t ob) const { return ob < 0 || ob >= POINTS || ob >= objectCount() ? 0 : sinQ15(data[1+4*ob]); } // sin of the angle to object ob in Q15, 0 if ob is not in the frame
+  int16_t pathVectorX(int16_t pa) const { return pa < 0 || pa >= POINTS || pa >= pathCount() ? 0 : cosQ15(data[3+4*pa]); } // cos of the angle to path pa in Q15, 0 if pa is not in the frame
+  int16_t pathVectorY(int16_t pa) const { return pa < 0 || pa >= POINTS || pa >= pathCount() ? 0 : sinQ15(data[3+4*pa]); } // sin of the angle to path pa in Q15, 0 if pa is not in the frame
+  static int16_t toBearing(uint8_t angle) { return (int16_t)(((uint32_t)angle*Q15ONE + 127)/255); } // Angle byte to Q15 half turns, rounded
+  static int16_t toRadians(uint8_t angle) { return (int16_t)(((uint32_t)angle*Q12PI + 127)/255); } // Angle byte to radians in Q12 (4096 is 1.0), 0 to Q12PI
+  static int16_t sinQ15(uint8_t angle) { return PROTRACTOR_READWAVE(angle <= 127 ? 2*angle : 510 - 2*angle); } // sin of an angle byte in Q15, 0 to Q15ONE
+  static int16_t cosQ15(uint8_t angle) { return angle <= 127 ? PROTRACTOR_READWAVE(255 - 2*angle) : -PROTRACTOR_READWAVE(2*angle - 255); } // cos of an angle byte in Q15, -Q15ONE to Q15ONE
+  static int16_t toDegrees(uint8_t angle) { return (int16_t)((uint16_t)angle*180/255); } // Same result as map(angle,0,255,0,180), in 16 bit arithmetic
+  static int16_t toDegreesQ7(uint8_t angle) { return (int16_t)(((uint32_t)angle*(180*128) + 127)/255); } // Angle byte to degrees in 128ths, rounded. Shift right by 7 for whole degrees.
+  static uint8_t toAngleByte(int16_t degrees) { return degrees <= 0 ? 0 : degrees >= 180 ? 255 : (uint8_t)(((uint16_t)degrees*255 + 90)/180); } // Nearest angle byte to degrees
+  static constexpr uint8_t firstSector(int16_t degrees) { // Sector of the lowest angle byte that toDegrees() turns into degrees
+    return degrees <= 0 ? 0 : degrees > 180 ? SECTORS - 1 : (uint8_t)((((uint16_t)degrees*255 + 179)/180) >> SECTORSHIFT);
+  }
+  static constexpr uint8_t lastSector(int16_t degrees) { // Sector of the highest angle byte that toDegrees() turns into degrees
+    return degrees < 0 ? 0 : degrees >= 180 ? SECTORS - 1 : (uint8_t)(((((uint16_t)degrees + 1)*255 + 179)/180 - 1) >> SECTORSHIFT);
+  }
+  static constexpr uint32_t sectorMask(int16_t fromDegrees, int16_t toDegrees) { // Sectors holding every angle from fromDegrees to toDegrees, both included. A constant when both are.
+    return (lastSector(toDegrees) == SECTORS - 1 ? 0xFFFFFFFFUL : ((uint32_t)2 << lastSector(toDegrees)) - 1) & ~(((uint32_t)1 << firstSector(fromDegrees)) - 1);
+  }
+
+  private:
+    static uint8_t received(int16_t count, uint8_t length) { // count, limited to the data points held by length bytes
+      uint8_t points = length > 0 ? (length - 1) / 4 : 0;
+      if(points > POINTS) points = POINTS;
+      return count < points ? (uint8_t)count : points;
+    }
+    uint32_t sectors(uint8_t offset, uint8_t received) const {
+      uint32_t mask = 0;
+      for(uint8_t i = 0; i < received; i++) mask |= (uint32_t)1 << (data[offset+4*i] >> SECTORSHIFT);
+      return mask;
+    }
+    int16_t byAngle(uint8_t offset, uint8_t received, int16_t i) const {
+      if(i < 0 || i >= received) return -1;
+      uint8_t order[POINTS];
+      sortByAngle(offset, received, order);
+      return order[i];
+    }
+    // Orders the slots by the angle byte at data[offset+4*slot]. Slots from received on sort last.
+    // The network (0,1) (2,3) (0,2) (1,3) (1,2) sorts any 4 keys; comparators reaching past POINTS drop out when compiling.
+    void sortByAngle(uint8_t offset, uint8_t received, uint8_t order[]) const {
+      static_assert(MAXOBJECTS == 4, "the sorting network is for 4 data points");
+      uint16_t key[POINTS];
+      for(uint8_t i = 0; i < POINTS; i++) {
+        order[i] = i;
+        key[i] = i < received ? data[offset+4*i] : 0x100;
+      }
+      if(POINTS > 1) exchange(key, order, 0, 1);
+      if(POINTS > 3) exchange(key, order, 2, 3);
+      if(POINTS > 2) exchange(key, order, 0, 2);
+      if(POINTS > 3) exchange(key, order, 1, 3);
+      if(POINTS > 2) exchange(key, order, 1, 2);
+    }
+    static void exchange(uint16_t key[], uint8_t order[], uint8_t a, uint8_t b) {
+      if(key[b] >= key[a]) return;
+      uint16_t k = key[a]; key[a] = key[b]; key[b] = k;
+      uint8_t o = order[a]; order[a] = order[b]; order[b] = o;
+    }
+    // The slot whose angle is closest to degrees. Of two as close, the one at the lower angle.
+    int16_t nearest(uint8_t offset, uint8_t received, int16_t degrees) const {
+      uint8_t target = toAngleByte(degrees);
+      int16_t best = -1;
+      uint8_t bestDistance = 0;
+      for(uint8_t i = 0; i < received; i++) {
+        uint8_t angle = data[offset+4*i];
+        uint8_t distance = angle < target ? target - angle : angle - target;
+        if(best < 0 || distance < bestDistance || (distance == bestDistance && angle < data[offset+4*best])) {
+          best = i;
+          bestDistance = distance;
+        }
+      }
+      return best;
+    }
+};
+
+typedef ProtractorFrameOf<MAXOBJECTS> ProtractorFrame; // A full frame, as held by Protractor
+
+static_assert(sizeof(ProtractorFrameOf<1>) == 5, "a frame holds its bytes and nothing else");
+static_assert(sizeof(ProtractorFrame) == 1+4*MAXOBJECTS, "a frame holds its bytes and nothing else");
+
+#endif
@@ -0,0 +1,288 @@
+/*
+  ProtractorI2CBus.cpp - Shares one I2C bus between the Protractor Sensor and other devices
+  Copyright (c) 2017 William Moore.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "Arduino.h"
+#include "ProtractorI2CBus.h"
+
+ProtractorI2CJob::ProtractorI2CJob()
+{
+  address = 0;
+  writeData = 0;
+  writeLength = 0;
+  readData = 0;
+  readLength = 0;
+  separate = 0;
+  run = 0;
+  done = 0;
+  context = 0;
+  priority = I2CPRIORITYNORMAL;
+  period = 0;
+  deadline = 0;
+  busTime = 0;
+  status = TRANSFER_OK;
+  received = 0;
+  due = 0;
+  queued = 0;
+}
+
+ProtractorI2CBus::ProtractorI2CBus()
+{
+  _wire = 0;
+  _clock = 100000;
+  _count = 0;
+  _framePeriod = 0;
+  _lastFrame = 0;
+  _framed = 0;
+  _runs = 0;
+  _late = 0;
+  _frameWait = 0;
+  _maxFrameWait = 0;
+  _frame.priority = I2CPRIORITYHIGH;
+  _command.priority = I2CPRIORITYHIGH;
+}
+
+void ProtractorI2CBus::begin(TwoWire &wire, uint32_t clock) {
+  _wire = &wire;
+  _clock = clock;
+  _wire->begin();
+  _wire->setClock(_clock);
+}
+
+bool ProtractorI2CBus::submit(ProtractorI2CJob &job, uint32_t delay) {
+  if(job.queued || _count >= I2CBUSMAXJOBS) return 0;
+  job.due = micros() + delay;
+  job.status = TRANSFER_BUSY;
+  job.queued = 1;
+  _jobs[_count++] = &job;
+  return 1;
+}
+
+void ProtractorI2CBus::cancel(ProtractorI2CJob &job) {
+  for(uint8_t i = 0; i < _count; i++) {
+    if(_jobs[i] == &job) {
+      _jobs[i] = _jobs[--_count];
+      job.queued = 0;
+      if(job.status == TRANSFER_BUSY) job.status = TRANSFER_ERROR;
+      return;
+    }
+  }
+}
+
+void ProtractorI2CBus::update() {
+  _service(0);
+}
+
+void ProtractorI2CBus::framePeriod(uint32_t microSeconds) {
+  _framePeriod = microSeconds;
+}
+
+// Every byte takes 9 clocks with its acknowledge bit, start, repeated start and stop about one clock each.
+// A write and read in separate transactions pay for a second stop, the bus free time and a second setup.
+uint32_t ProtractorI2CBus::estimate(const ProtractorI2CJob &job) {
+  if(job.run || job.busTime) return job.busTime;
+  uint32_t bits = 0;
+  uint32_t transactions = 0;
+  if(job.writeLength > 0) {
+    bits += 9*(1 + (uint32_t)job.writeLength) + 2;
+    transactions++;
+  }
+  if(job.readLength > 0) {
+    bits += 9*(1 + (uint32_t)job.readLength) + 2;
+    transactions++;
+  }
+  if(transactions == 2 && !job.separate) {
+    bits -= 1; // The repeated start replaces a stop and a start
+    transactions = 1;
+  }
+  uint32_t time = bits*1000000/_clock + transactions*I2CSETUPTIME;
+  if(transactions == 2) time += I2CBUSFREETIME*100000/_clock;
+  return time;
+}
+
+uint32_t ProtractorI2CBus::runs() {
+  return _runs;
+}
+
+uint32_t ProtractorI2CBus::late() {
+  return _late;
+}
+
+uint32_t ProtractorI2CBus::frameWait() {
+  return _frameWait;
+}
+
+uint32_t ProtractorI2CBus::maxFrameWait() {
+  return _maxFrameWait;
+}
+
+/////// TRANSPORT ///////
+
+// A frame is a high priority job, run before startRead() returns unless an equally urgent job is ahead of it
+bool ProtractorI2CBus::startRead(uint8_t address, uint8_t frame[], uint8_t length) {
+  return startWriteRead(address, 0, 0, frame, length);
+}
+
+bool ProtractorI2CBus::startWriteRead(uint8_t address, const uint8_t data[], uint8_t writeLength, uint8_t frame[], uint8_t length) {
+  if(!_wire || _frame.queued) return 0;
+  _frame.address = address;
+  _frame.writeData = data;
+  _frame.writeLength = writeLength;
+  _frame.readData = frame;
+  _frame.readLength = length;
+  _frame.received = 0;
+  if(!submit(_frame)) return 0;
+  _service(&_frame); // A high priority job is never held back, so the frame has run when this returns
+  return 1;
+}
+
+uint8_t ProtractorI2CBus::receive(uint8_t frame[], uint8_t received, uint8_t length) {
+  (void)frame; (void)length;
+  if(_frame.queued) {
+    _service(&_frame);
+    if(_frame.queued) return received;
+  }
+  return _frame.received;
+}
+
+bool ProtractorI2CBus::busy() {
+  return _frame.queued;
+}
+
+void ProtractorI2CBus::write(uint8_t address, const uint8_t data[], uint8_t length) {
+  if(!_wire) return;
+  _command.address = address;
+  _command.writeData = data;
+  _command.writeLength = length;
+  if(!submit(_command)) return;
+  _service(&_command); // data is only valid until write() returns
+  cancel(_command);
+}
+
+bool ProtractorI2CBus::singleCommand() {
+  return 1;
+}
+
+bool ProtractorI2CBus::setClock(uint32_t clock) {
+  if(!_wire || clock == 0) return 0;
+  _clock = clock;
+  _wire->setClock(_clock);
+  return 1;
+}
+
+/////// PRIVATE FUNCTIONS ///////
+
+// Runs due jobs back to back. Stops when nothing can run, or once until has run.
+void ProtractorI2CBus::_service(ProtractorI2CJob *until) {
+  while(!until || until->queued) {
+    unsigned long now = micros();
+    int8_t next = _pick(now);
+    if(next < 0) return;
+    ProtractorI2CJob &job = *_jobs[next];
+    if(!_fits(job, now)) return;
+    _jobs[next] = _jobs[--_count];
+    job.queued = 0;
+    _run(job, now);
+  }
+}
+
+// Finds the due job with the highest priority, and the earliest deadline among equals. Returns -1 if none is due.
+int8_t ProtractorI2CBus::_pick(unsigned long now) {
+  int8_t best = -1;
+  for(uint8_t i = 0; i < _count; i++) {
+    ProtractorI2CJob &job = *_jobs[i];
+    if((long)(now - job.due) < 0) continue;
+    if(best < 0) {
+      best = i;
+      continue;
+    }
+    ProtractorI2CJob &other = *_jobs[best];
+    if(job.priority != other.priority) {
+      if(job.priority > other.priority) best = i;
+    } else if((long)((job.due + job.deadline) - (other.due + other.deadline)) < 0) {
+      best = i;
+    }
+  }
+  return best;
+}
+
+// returns false if job would still hold the bus when a more urgent job, or the next Protractor frame, is due
+bool ProtractorI2CBus::_fits(const ProtractorI2CJob &job, unsigned long now) {
+  unsigned long end = now + estimate(job);
+  for(uint8_t i = 0; i < _count; i++) {
+    const ProtractorI2CJob &other = *_jobs[i];
+    if(other.priority > job.priority && (long)(other.due - now) > 0 && (long)(other.due - end) < 0) return 0;
+  }
+  if(_framePeriod > 0 && job.priority < I2CPRIORITYHIGH) {
+    unsigned long nextFrame = _lastFrame + _framePeriod;
+    if((long)(nextFrame - now) > 0 && (long)(nextFrame - end) < 0) return 0;
+  }
+  return 1;
+}
+
+void ProtractorI2CBus::_run(ProtractorI2CJob &job, unsigned long now) {
+  uint32_t wait = now - job.due;
+  if(job.deadline > 0 && wait > job.deadline) _late++;
+  if(&job == &_frame) {
+    if(_framePeriod > 0 && _framed) {
+      long behind = (long)(now - (_lastFrame + _framePeriod)); // Held up before startRead() was even called
+      if(behind > (long)wait) wait = behind;
+    }
+    _framed = 1;
+    _frameWait = wait;
+    if(wait > _maxFrameWait) _maxFrameWait = wait;
+    _lastFrame = now;
+  }
+  if(job.run) {
+    job.status = TRANSFER_OK;
+    job.run(job);
+  } else {
+    _transfer(job);
+  }
+  _runs++;
+  if(job.period > 0) {
+    job.due += job.period;
+    if((long)(micros() - job.due) >= 0) job.due = micros() + job.period; // Runs that were missed are skipped, not run back to back
+    job.queued = 1;
+    _jobs[_count++] = &job; // There is room, the job was just taken off the queue
+  }
+  if(job.done) job.done(job);
+}
+
+// A write of writeData, then a read of readData. Without separate, the write ends without a stop and the read starts with a repeated start.
+void ProtractorI2CBus::_transfer(ProtractorI2CJob &job) {
+  job.status = TRANSFER_OK;
+  job.received = 0;
+  if(job.writeLength > 0) {
+    bool stop = job.separate || job.readLength == 0;
+    _wire->beginTransmission(job.address);
+    _wire->write(job.writeData,job.writeLength);
+    uint8_t error = _wire->endTransmission(stop);
+    if(error != 0) {
+      job.status = (error == 2 || error == 3) ? TRANSFER_NACK : TRANSFER_ERROR;
+      return;
+    }
+  }
+  if(job.readLength > 0) {
+    uint8_t available = _wire->requestFrom(job.address,job.readLength);
+    while(job.received < available && _wire->available()) {
+      job.readData[job.received++] = _wire->read();
+    }
+    if(job.received < job.readLength) job.status = TRANSFER_NACK;
+  }
+}
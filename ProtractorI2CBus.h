@@ -0,0 +1,122 @@
+/*
+  ProtractorI2CBus.h - Shares one I2C bus between the Protractor Sensor and other devices
+  Copyright (c) 2017 William Moore.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+  ###########################################################################
+
+  On a robot like the Zumo, the Protractor shares Wire with an accelerometer or a compass, and whichever
+  device the sketch happens to read first holds up the other. A ProtractorI2CBus owns the TwoWire and
+  decides the order instead. Every transaction is a ProtractorI2CJob with a priority, the time it is due
+  and an optional deadline. update() runs the due jobs back to back, the highest priority first and the
+  earliest deadline first among equals.
+
+  Protractor frames and commands go through the bus as I2CPRIORITYHIGH jobs when the Protractor is started
+  with Protractor.begin(bus,address), and are run at once. A Wire transaction cannot be interrupted, so a
+  lower priority job is only started if it will be over before the next more urgent job is due, including
+  the next Protractor frame when the sketch has given framePeriod(). Each job's bus time is estimated from
+  its length and the I2C clock. A job that runs its own Wire code, such as a call into the LSM303 library,
+  gives its bus time itself.
+
+  A job with both writeData and readData, such as a register read, is one transaction: the read follows
+  the write with a repeated start, so no other master can take the bus in between. Set separate for a
+  device that wants a stop after the write.
+
+  ############################################################################
+*/
+
+#ifndef ProtractorI2CBus_h
+#define ProtractorI2CBus_h
+
+#include <inttypes.h>
+#include <Wire.h>
+#include "ProtractorTransport.h"
+
+#define I2CBUSMAXJOBS     8 // Jobs that can be queued at once
+#define I2CPRIORITYLOW    0 // Background reads, such as an accelerometer or a compass
+#define I2CPRIORITYNORMAL 1
+#define I2CPRIORITYHIGH   2 // Protractor frames and commands
+#define I2CSETUPTIME      20 // micro-seconds Wire spends around each transaction, added to bus time estimates
+#define I2CBUSFREETIME    5 // micro-seconds the bus must stay free between a stop and the next start, at 100kHz
+
+// One I2C transaction, or a client function doing its own transactions on the bus' TwoWire.
+// Set the fields, then hand the job to ProtractorI2CBus.submit(). The job must stay in memory while queued.
+struct ProtractorI2CJob
+{
+  ProtractorI2CJob();
+  uint8_t address; // 7 bit I2C address
+  const uint8_t* writeData; // Bytes written first, such as a register number
+  uint8_t writeLength;
+  uint8_t* readData; // Bytes read after the write
+  uint8_t readLength;
+  bool separate; // true to end the write with a stop and read in a transaction of its own. Default is false: the read follows a repeated start.
+  void (*run)(ProtractorI2CJob &job); // If set, called to do the transfer instead of writeData and readData
+  void (*done)(ProtractorI2CJob &job); // If set, called after the job has run
+  void* context; // Free for the sketch, for example the device object the job belongs to
+  uint8_t priority; // I2CPRIORITYLOW, I2CPRIORITYNORMAL or I2CPRIORITYHIGH. Default is I2CPRIORITYNORMAL.
+  uint32_t period; // micro-seconds between runs of a job that repeats by itself, 0 to run once
+  uint32_t deadline; // micro-seconds after it is due by which the job should have started, 0 for none
+  uint16_t busTime; // micro-seconds the job holds the bus. 0 to estimate it from writeLength and readLength; must be set with run.
+  // Set by the bus
+  uint8_t status; // TRANSFER_OK, TRANSFER_BUSY while queued, TRANSFER_NACK or TRANSFER_ERROR
+  uint8_t received; // Bytes read by the most recent run
+  unsigned long due; // micros() when the job may run next
+  bool queued;
+};
+
+class ProtractorI2CBus : public ProtractorTransport
+{
+  public:
+    ProtractorI2CBus();
+    void begin(TwoWire &wire, uint32_t clock = 100000); // Takes over wire and starts it as bus master, with an I2C clock of clock Hz
+    bool submit(ProtractorI2CJob &job, uint32_t delay = 0); // Queues job to run after delay micro-seconds. Returns false if the job is already queued or the queue is full.
+    void cancel(ProtractorI2CJob &job); // Takes job off the queue, which also stops a repeating job
+    void update(); // Call from the loop. Runs the due jobs that can run without holding up a more urgent one.
+    void framePeriod(uint32_t microSeconds); // Tells the bus how often Protractor frames are read, so that lower priority jobs keep out of their way. 0, the default, for no reservation.
+    uint32_t estimate(const ProtractorI2CJob &job); // returns the micro-seconds job is expected to hold the bus
+    uint32_t runs(); // returns the number of jobs run
+    uint32_t late(); // returns the number of jobs that started after their deadline
+    uint32_t frameWait(); // returns the micro-seconds the most recent Protractor frame waited for the bus. With framePeriod(), time it started late is counted too.
+    uint32_t maxFrameWait(); // returns the longest wait of a Protractor frame for the bus, in micro-seconds
+    virtual bool startRead(uint8_t address, uint8_t frame[], uint8_t length);
+    virtual uint8_t receive(uint8_t frame[], uint8_t received, uint8_t length);
+    virtual bool busy();
+    virtual bool startWriteRead(uint8_t address, const uint8_t data[], uint8_t writeLength, uint8_t frame[], uint8_t length); // data is sent before startWriteRead() returns
+    virtual void write(uint8_t address, const uint8_t data[], uint8_t length);
+    virtual bool singleCommand();
+    virtual bool setClock(uint32_t clock); // Changes the I2C clock. Bus time estimates follow the new clock.
+  private:
+    void _service(ProtractorI2CJob *until);
+    int8_t _pick(unsigned long now);
+    bool _fits(const ProtractorI2CJob &job, unsigned long now);
+    void _run(ProtractorI2CJob &job, unsigned long now);
+    void _transfer(ProtractorI2CJob &job);
+    TwoWire* _wire;
+    uint32_t _clock; // I2C clock in Hz
+    ProtractorI2CJob* _jobs[I2CBUSMAXJOBS]; // Queued jobs, in no particular order
+    uint8_t _count;
+    ProtractorI2CJob _frame; // Used by startRead()
+    ProtractorI2CJob _command; // Used by write()
+    uint32_t _framePeriod;
+    unsigned long _lastFrame; // micros() when the most recent Protractor frame started
+    bool _framed; // A Protractor frame has been read
+    uint32_t _runs;
+    uint32_t _late;
+    uint32_t _frameWait;
+    uint32_t _maxFrameWait;
+};
+
+#endif
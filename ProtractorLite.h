@@ -0,0 +1,89 @@
+/*
+  ProtractorLite.h - Smallest reader for the Protractor Sensor, sized at compile time
+  Copyright (c) 2017 William Moore.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+  ###########################################################################
+
+  Protractor carries a full 17 byte frame, its own Wire and Stream transports, the read callbacks and the
+  settings commands, whether a sketch uses them or not. On a small board, a sketch that only ever calls
+  read(1) pays for all of it. ProtractorLite<POINTS> only reads: POINTS data points per frame, fixed at
+  compile time, into a frame of 1+4*POINTS bytes, through a transport the sketch starts itself.
+
+    ProtractorWireTransport link;
+    ProtractorLite<1> protractor; // 5 byte frame
+
+    link.begin(Wire);
+    protractor.begin(link, 0x45);
+    if(protractor.read()) angle = protractor.objectAngle();
+
+  Everything is defined in this header, so only what the sketch calls is compiled in. A sketch that also
+  changes settings can keep a Protractor on the same transport for them. extras/avrbench "make size"
+  reports the flash and SRAM of a read(1) sketch built with each; it has not been run yet, so no sizes
+  are given here.
+
+  ############################################################################
+*/
+
+#ifndef ProtractorLite_h
+#define ProtractorLite_h
+
+#include <inttypes.h>
+#include "ProtractorFrame.h"
+#include "ProtractorTransport.h"
+
+template<uint8_t POINTS = MAXOBJECTS>
+class ProtractorLite
+{
+  public:
+    ProtractorLite() : _transport(0), _address(0), _received(0) { _frame.data[0] = 0; }
+    void begin(ProtractorTransport &transport, uint8_t address = 0) { _transport = &transport; _address = address; } // Use transport, which must already be started. address is the sensor's address on links that have one.
+    bool read() { // gets POINTS objects and paths from the protractor. Returns false if the sensor did not answer.
+      _received = _transport ? _transport->readFrame(_address,_frame.data,sizeof(_frame.data)) : 0;
+      return _received > 0;
+    }
+    uint8_t frameLength() const { return _received; } // returns the number of bytes received during the most recent read, 0 if nothing was received
+    const ProtractorFrameOf<POINTS>& frame() const { return _frame; } // returns the most recent frame
+    int16_t objectCount() const { return _frame.objectCount(); } // returns the number of objects detected, which can be more than POINTS
+    int16_t pathCount() const { return _frame.pathCount(); } // returns the number of paths detected, which can be more than POINTS
+    int16_t objectAngle(int16_t ob = 0) const { return _frame.objectAngle(ob); } // returns the angle to object ob, -1 if ob is not in the frame
+    int16_t objectVisibility(int16_t ob = 0) const { return _frame.objectVisibility(ob); } // returns the visibility of object ob, -1 if ob is not in the frame
+    int16_t pathAngle(int16_t pa = 0) const { return _frame.pathAngle(pa); } // returns the angle to path pa, -1 if pa is not in the frame
+    int16_t pathVisibility(int16_t pa = 0) const { return _frame.pathVisibility(pa); } // returns the visibility of path pa, -1 if pa is not in the frame
+    uint32_t objectSectors() const { return _frame.objectSectors(_received); } // returns a bit for each sector an object was received in, see ProtractorFrame.h
+    uint32_t pathSectors() const { return _frame.pathSectors(_received); } // returns a bit for each sector a path was received in
+    int16_t objectByAngle(int16_t i) const { return _frame.objectByAngle(i,_received); } // returns the ob of the i-th object received counting up from 0 degrees, -1 if fewer were received
+    int16_t pathByAngle(int16_t i) const { return _frame.pathByAngle(i,_received); } // returns the pa of the i-th path received counting up from 0 degrees, -1 if fewer were received
+    int16_t nearestObjectTo(int16_t degrees) const { return _frame.nearestObjectTo(degrees,_received); } // returns the ob of the object closest to degrees, -1 if none was received
+    int16_t nearestPathTo(int16_t degrees) const { return _frame.nearestPathTo(degrees,_received); } // returns the pa of the path closest to degrees, -1 if none was received
+    int16_t objectAngleRaw(int16_t ob = 0) const { return _frame.objectAngleRaw(ob); } // returns the angle byte of object ob, 0 to 255, -1 if ob is not in the frame
+    int16_t pathAngleRaw(int16_t pa = 0) const { return _frame.pathAngleRaw(pa); } // returns the angle byte of path pa, 0 to 255, -1 if pa is not in the frame
+    int16_t objectAngleQ7(int16_t ob = 0) const { return _frame.objectAngleQ7(ob); } // returns the angle to object ob in 128ths of a degree, -1 if ob is not in the frame
+    int16_t pathAngleQ7(int16_t pa = 0) const { return _frame.pathAngleQ7(pa); } // returns the angle to path pa in 128ths of a degree, -1 if pa is not in the frame
+    int16_t objectBearing(int16_t ob = 0) const { return _frame.objectBearing(ob); } // returns the angle to object ob in Q15 half turns, -1 if ob is not in the frame
+    int16_t pathBearing(int16_t pa = 0) const { return _frame.pathBearing(pa); } // returns the angle to path pa in Q15 half turns, -1 if pa is not in the frame
+    int16_t objectVectorX(int16_t ob = 0) const { return _frame.objectVectorX(ob); } // returns cos(angle to object ob) in Q15, 0 if ob is not in the frame
+    int16_t objectVectorY(int16_t ob = 0) const { return _frame.objectVectorY(ob); } // returns sin(angle to object ob) in Q15, 0 if ob is not in the frame
+    int16_t pathVectorX(int16_t pa = 0) const { return _frame.pathVectorX(pa); } // returns cos(angle to path pa) in Q15, 0 if pa is not in the frame
+    int16_t pathVectorY(int16_t pa = 0) const { return _frame.pathVectorY(pa); } // returns sin(angle to path pa) in Q15, 0 if pa is not in the frame
+  private:
+    ProtractorFrameOf<POINTS> _frame;
+    ProtractorTransport* _transport;
+    uint8_t _address;
+    uint8_t _received;
+};
+
+#endif
@@ -0,0 +1,130 @@
+/*
+  ProtractorLog.h - Binary frame log format for the Protractor Sensor
+  Copyright (c) 2017 William Moore.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+  ###########################################################################
+
+  A frame log is what ProtractorRecorder writes: every frame returned by Protractor.read(), exactly as it
+  was received, with a sequence number and a micro-second timestamp. This header only describes the format
+  and does not depend on the Arduino core, so the same definitions are used by the recorder on the robot
+  and by the tools that read logs back on a PC.
+
+  A log starts with an 8 byte header:
+    [0..3] 'P' 'R' 'L' 'G'   [4] LOGVERSION   [5] LOGMAXFRAME   [6..7] reserved, 0
+
+  followed by one record per read(), all values little endian:
+    [0] LOGSYNC   [1] length   [2..5] sequence   [6..9] micros() timestamp   [10..] length bytes of frame
+
+  length is the number of bytes received during that read and is 0 when the sensor did not answer, so
+  timeouts are kept in the log too. The sequence number increases by one per record; a gap means records
+  were lost. A reader that meets a damaged record skips ahead to the next LOGSYNC byte.
+
+  ############################################################################
+*/
+
+#ifndef ProtractorLog_h
+#define ProtractorLog_h
+
+#include <inttypes.h>
+#include <string.h>
+
+#define LOGVERSION    1
+#define LOGSYNC       0xA5
+#define LOGHEADERSIZE 8  // Bytes in the log header
+#define LOGRECORDSIZE 10 // Bytes in a record before the frame bytes
+#define LOGMAXFRAME   17 // Largest frame a record can hold, 1+4*MAXOBJECTS
+
+// One record of a frame log
+struct ProtractorLogRecord
+{
+  uint32_t sequence; // Record number, counting from 0
+  uint32_t timestamp; // micros() when the frame was read
+  uint8_t length; // Number of frame bytes received, 0 if the sensor did not answer
+  uint8_t frame[LOGMAXFRAME]; // Frame bytes, as returned by Protractor.frameData()
+};
+
+class ProtractorLog
+{
+  public:
+    // Writes the log header to data[LOGHEADERSIZE]. Returns LOGHEADERSIZE.
+    static uint8_t writeHeader(uint8_t data[]) {
+      data[0] = 'P'; data[1] = 'R'; data[2] = 'L'; data[3] = 'G';
+      data[4] = LOGVERSION;
+      data[5] = LOGMAXFRAME;
+      data[6] = 0;
+      data[7] = 0;
+      return LOGHEADERSIZE;
+    }
+
+    // returns true if data[LOGHEADERSIZE] is a header this version of the library can read
+    static bool checkHeader(const uint8_t data[]) {
+      return data[0] == 'P' && data[1] == 'R' && data[2] == 'L' && data[3] == 'G' && data[4] == LOGVERSION && data[5] <= LOGMAXFRAME;
+    }
+
+    // Writes record to data[], which must hold LOGRECORDSIZE+LOGMAXFRAME bytes. Returns the number of bytes written.
+    static uint8_t writeRecord(const ProtractorLogRecord &record, uint8_t data[]) {
+      uint8_t length = record.length > LOGMAXFRAME ? LOGMAXFRAME : record.length;
+      data[0] = LOGSYNC;
+      data[1] = length;
+      _put32(data+2,record.sequence);
+      _put32(data+6,record.timestamp);
+      memcpy(data+LOGRECORDSIZE,record.frame,length);
+      return LOGRECORDSIZE+length;
+    }
+
+    // Reads the next record from data[size]. Damaged bytes in front of the record are skipped, and their number
+    // is stored in skipped. Returns the number of bytes used, including skipped bytes, or 0 if no complete
+    // record is left in data.
+    static uint32_t readRecord(const uint8_t data[], uint32_t size, ProtractorLogRecord &record, uint32_t &skipped) {
+      uint32_t pos = 0;
+      while(pos < size && (data[pos] != LOGSYNC || (pos+1 < size && data[pos+1] > LOGMAXFRAME))) pos++;
+      skipped = pos;
+      if(size - pos < LOGRECORDSIZE) return 0;
+      uint8_t length = data[pos+1];
+      if(size - pos < (uint32_t)LOGRECORDSIZE+length) return 0;
+      record.length = length;
+      record.sequence = _get32(data+pos+2);
+      record.timestamp = _get32(data+pos+6);
+      memcpy(record.frame,data+pos+LOGRECORDSIZE,length);
+      return pos+LOGRECORDSIZE+length;
+    }
+
+    // CRC-8, polynomial 0x07. Also protects stored profiles and telemetry packets.
+    static uint8_t crc8(const uint8_t data[], uint8_t length) {
+      uint8_t crc = 0;
+      for(uint8_t i = 0; i < length; i++){
+        crc ^= data[i];
+        for(uint8_t b = 0; b < 8; b++){
+          crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+      }
+      return crc;
+    }
+
+  private:
+    static void _put32(uint8_t data[], uint32_t value) {
+      data[0] = (uint8_t)value;
+      data[1] = (uint8_t)(value >> 8);
+      data[2] = (uint8_t)(value >> 16);
+      data[3] = (uint8_t)(value >> 24);
+    }
+    static uint32_t _get32(const uint8_t data[]) {
+      return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+    }
+};
+
+#endif
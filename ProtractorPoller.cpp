@@ -0,0 +1,262 @@
+/*
+  ProtractorPoller.cpp - Reads several Protractor Sensors that share one link, in turn
+  Copyright (c) 2017 William Moore.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "Arduino.h"
+#include "ProtractorPoller.h"
+
+ProtractorPoller::ProtractorPoller()
+{
+  _onFrame = 0;
+  _onRound = 0;
+  _broadcast = 0;
+  _count = 0;
+  _current = 0;
+  _slots = 1;
+  _running = 0;
+  _begun = 0;
+  _synchronized = 0;
+  _nextSlot = 0;
+  _scanned = 0;
+  _lastTrigger = 0;
+  _triggerSkew = 0;
+  _slotTime = 0;
+  _minSlotTime = 0;
+  _slotTimed = 0;
+  _requestTime = 0;
+  _roundStart = 0;
+  _roundTime = 0;
+}
+
+// Adds a sensor to the end of the round
+bool ProtractorPoller::add(Protractor &protractor, int16_t obs) {
+  if(_count >= POLLERMAXSENSORS) return 0;
+  if(obs > MAXOBJECTS) obs = MAXOBJECTS;
+  _sensors[_count] = &protractor;
+  _obs[_count] = obs;
+  _separated[_count] = 0;
+  _frames[_count] = 0;
+  _timeouts[_count] = 0;
+  _latency[_count] = 0;
+  _averageLatency[_count] = 0;
+  _maxLatency[_count] = 0;
+  _count++;
+  _plan();
+  return 1;
+}
+
+void ProtractorPoller::onFrame(void (*callback)(uint8_t sensor, Protractor &protractor)) {
+  _onFrame = callback;
+}
+
+void ProtractorPoller::onRound(void (*callback)()) {
+  _onRound = callback;
+}
+
+// Sensors set to scanTime(0) only scan when triggered or read
+bool ProtractorPoller::synchronize(Protractor *broadcast) {
+#if !PROTRACTOR_TRIGGER
+  (void)broadcast;
+  return 0; // Rounds would have nothing to start the scans with
+#else
+  _broadcast = broadcast;
+  if(_broadcast) {
+    _broadcast->scanTime(0);
+  } else {
+    for(uint8_t i = 0; i < _count; i++) _sensors[i]->scanTime(0);
+  }
+  _synchronized = 1;
+  _nextSlot = 0;
+  _scanned = 0;
+  _lastTrigger = micros() - POLLERSCANWAIT; // The first slot can be triggered at once
+  _minSlotTime = 0;
+  _slotTimed = 0;
+  return 1;
+#endif
+}
+
+bool ProtractorPoller::separate(uint8_t sensorA, uint8_t sensorB) {
+  if(sensorA >= _count || sensorB >= _count || _running) return 0;
+  if(sensorA == sensorB) return 1;
+  _separated[sensorA] |= (uint8_t)(1 << sensorB);
+  _separated[sensorB] |= (uint8_t)(1 << sensorA);
+  _plan();
+  return 1;
+}
+
+uint8_t ProtractorPoller::slots() {
+  return _slots;
+}
+
+uint8_t ProtractorPoller::slot(uint8_t sensor) {
+  return sensor < _count ? _slotOf[sensor] : 0;
+}
+
+// Finishes the running read, starts the next one, then hands the finished frame to the sketch
+void ProtractorPoller::update() {
+  if(_count == 0) return;
+  if(!_running) {
+    if(!_begun) {
+      _begun = 1;
+      _roundStart = micros(); // First round
+    }
+    _next();
+    return;
+  }
+  uint8_t sensor = _order[_current];
+  Protractor &protractor = *_sensors[sensor];
+  if(!protractor.readComplete()) return;
+  if(protractor.frameLength() > 0) {
+    uint32_t latency = micros() - _requestTime;
+    _latency[sensor] = latency;
+    if(_frames[sensor] == 0) _averageLatency[sensor] = latency;
+    else _averageLatency[sensor] += ((int32_t)(latency - _averageLatency[sensor])) / 8; // Moving average over about 8 reads
+    if(latency > _maxLatency[sensor]) _maxLatency[sensor] = latency;
+    _frames[sensor]++;
+  } else {
+    _timeouts[sensor]++;
+  }
+  _current++;
+  bool roundDone = _current >= _count;
+  if(roundDone || _slotOf[_order[_current]] != _slotOf[sensor]) {
+    _scanned &= (uint8_t)~(1 << _slotOf[sensor]); // Every frame of this slot is in, it may scan again
+  }
+  if(roundDone) {
+    _current = 0;
+    unsigned long now = micros();
+    _roundTime = now - _roundStart;
+    _roundStart = now;
+  }
+  _running = 0;
+  _next(); // The next sensor answers, or scans, while the sketch looks at this frame
+  if(_onFrame) _onFrame(sensor, protractor);
+  if(roundDone && _onRound) _onRound();
+}
+
+uint8_t ProtractorPoller::count() {
+  return _count;
+}
+
+uint32_t ProtractorPoller::frames(uint8_t sensor) {
+  return sensor < _count ? _frames[sensor] : 0;
+}
+
+uint32_t ProtractorPoller::timeouts(uint8_t sensor) {
+  return sensor < _count ? _timeouts[sensor] : 0;
+}
+
+uint32_t ProtractorPoller::latency(uint8_t sensor) {
+  return sensor < _count ? _latency[sensor] : 0;
+}
+
+uint32_t ProtractorPoller::averageLatency(uint8_t sensor) {
+  return sensor < _count ? _averageLatency[sensor] : 0;
+}
+
+uint32_t ProtractorPoller::maxLatency(uint8_t sensor) {
+  return sensor < _count ? _maxLatency[sensor] : 0;
+}
+
+uint32_t ProtractorPoller::roundTime() {
+  return _roundTime;
+}
+
+uint32_t ProtractorPoller::triggerSkew() {
+  return _triggerSkew;
+}
+
+uint32_t ProtractorPoller::slotTime() {
+  return _slotTime;
+}
+
+uint32_t ProtractorPoller::minSlotTime() {
+  return _minSlotTime;
+}
+
+/////// PRIVATE FUNCTIONS ///////
+
+// Puts each sensor in the first slot that holds none of the sensors it is separated from, then orders the reads
+// by slot. Taking the sensors in the order they were added keeps the plan the same from one boot to the next.
+void ProtractorPoller::_plan() {
+  _slots = 1;
+  for(uint8_t i = 0; i < _count; i++) {
+    uint8_t taken = 0; // Slots used by sensors separated from sensor i
+    for(uint8_t j = 0; j < i; j++) {
+      if(_separated[i] & (1 << j)) taken |= (uint8_t)(1 << _slotOf[j]);
+    }
+    uint8_t slot = 0;
+    while(taken & (1 << slot)) slot++;
+    _slotOf[i] = slot;
+    if(slot >= _slots) _slots = slot + 1;
+  }
+  uint8_t position = 0;
+  for(uint8_t slot = 0; slot < _slots; slot++) {
+    for(uint8_t i = 0; i < _count; i++) {
+      if(_slotOf[i] == slot) _order[position++] = i;
+    }
+  }
+}
+
+// Starts what comes next. In synchronized mode the next slot is triggered as soon as the previous slot's scan is
+// over and its own frames from the last round are collected, and a sensor is only read once its slot's scan is done.
+void ProtractorPoller::_next() {
+  if(_synchronized) {
+    unsigned long now = micros();
+    if(!(_scanned & (1 << _nextSlot)) && now - _lastTrigger >= POLLERSCANWAIT) {
+      _trigger(_nextSlot);
+      _nextSlot = _nextSlot + 1 < _slots ? _nextSlot + 1 : 0;
+    }
+    uint8_t slot = _slotOf[_order[_current]];
+    if(!(_scanned & (1 << slot)) || micros() - _slotTrigger[slot] < POLLERSCANWAIT) return;
+  }
+  _start();
+}
+
+// Requests a frame from the current sensor. If the link can't take the request yet, the next update() tries again.
+void ProtractorPoller::_start() {
+  _requestTime = micros();
+  _running = _sensors[_order[_current]]->startRead(_obs[_order[_current]]);
+}
+
+// Triggers a scan on every sensor of slot, as close together as the link allows. The skew is measured from the end
+// of the first trigger to the end of the last.
+void ProtractorPoller::_trigger(uint8_t slot) {
+  unsigned long first = 0;
+  if(_broadcast && _slots == 1) {
+    _broadcast->trigger();
+    first = micros();
+  } else {
+    bool triggered = 0;
+    for(uint8_t i = 0; i < _count; i++) {
+      if(_slotOf[i] != slot) continue;
+      _sensors[i]->trigger();
+      if(!triggered) first = micros();
+      triggered = 1;
+    }
+  }
+  unsigned long now = micros();
+  _triggerSkew = (_broadcast && _slots == 1) ? 0 : now - first;
+  if(_slotTimed) {
+    _slotTime = now - _lastTrigger;
+    if(_minSlotTime == 0 || _slotTime < _minSlotTime) _minSlotTime = _slotTime;
+  }
+  _slotTrigger[slot] = now;
+  _lastTrigger = now;
+  _slotTimed = 1;
+  _scanned |= (uint8_t)(1 << slot);
+}
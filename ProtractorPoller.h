@@ -0,0 +1,113 @@
+/*
+  ProtractorPoller.h - Reads several Protractor Sensors that share one link, in turn
+  Copyright (c) 2017 William Moore.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+  ###########################################################################
+
+  Sensors on a shared link, such as an RS-485 multi-drop bus, can only answer one at a time. The
+  ProtractorPoller reads them round-robin without waiting: as soon as one sensor's frame is complete,
+  the request to the next sensor goes out, and only then is the finished frame handed to the sketch's
+  callback. The sketch works on one frame while the next one is on the wire.
+
+  For every sensor the poller keeps the number of frames and timeouts and the latency of its reads, from
+  the request to the last byte of the answer, so a slow node or a bad cable stands out.
+
+  Sensors that scan freely run out of phase with each other, and their IR emitters can light up each
+  other's scans. In synchronized mode every sensor is set to scanTime(0) and only scans when triggered.
+  Each round starts by triggering all sensors, in one broadcast on an RS-485 bus or back to back on other
+  links, waits POLLERSCANWAIT for the scans, then collects the frames one by one. The frames of one round
+  then describe the same instant, and the onRound() function is called once all of them are in.
+
+  Sensors that face each other, or whose fields of view overlap, can be kept apart with separate(). The
+  sensors are then split into time slots, as few as possible, so that no slot holds two sensors that were
+  separated. One slot scans at a time, for POLLERSCANWAIT each, and the frames of a slot are collected
+  while the next slot scans, so the sensors give a frame every slots()*POLLERSCANWAIT. slotTime() and
+  minSlotTime() report the measured time between the triggers of consecutive slots; minSlotTime() never
+  below POLLERSCANWAIT shows that no two slots scanned at once.
+
+  ############################################################################
+*/
+
+#ifndef ProtractorPoller_h
+#define ProtractorPoller_h
+
+#include <inttypes.h>
+#include "Protractor.h"
+
+#define POLLERMAXSENSORS 8 // Number of sensors one poller can schedule
+#define POLLERSCANWAIT   (MINDUR*1000UL) // micro-seconds from the trigger until the scans are ready, in synchronized mode
+
+class ProtractorPoller
+{
+  public:
+    ProtractorPoller();
+    bool add(Protractor &protractor, int16_t obs = MAXOBJECTS); // Adds a sensor, already started with Protractor.begin(), to the end of the round. obs objects and paths are read from it. Returns false if POLLERMAXSENSORS sensors are already scheduled.
+    void onFrame(void (*callback)(uint8_t sensor, Protractor &protractor)); // Sets a function to call with each frame read. sensor is the order in which the Protractor was added, from 0. Timeouts are passed too, with protractor.frameLength() 0.
+    void onRound(void (*callback)()); // Sets a function to call after the last sensor's frame of each round
+    bool synchronize(Protractor *broadcast = 0); // Call after add() and separate(). Sets every sensor to scanTime(0) and switches to synchronized rounds. Returns false, and changes nothing, if PROTRACTOR_TRIGGER is 0. broadcast is a Protractor started on the RS-485 broadcast address, to trigger every sensor with one command, or 0 to trigger them one after the other. The broadcast is only used while all sensors share one slot.
+    bool separate(uint8_t sensorA, uint8_t sensorB); // In synchronized mode, sensorA and sensorB never scan at the same time. Call before the first update(). Returns false if either sensor was not added, or a read is running.
+    uint8_t slots(); // returns the number of time slots in a synchronized round
+    uint8_t slot(uint8_t sensor); // returns the time slot sensor scans in, from 0
+    void update(); // Call from the loop. Finishes the running read when its frame is complete, starts the next one, then calls the onFrame() function.
+    uint8_t count(); // returns the number of sensors scheduled
+    uint32_t frames(uint8_t sensor); // returns the number of frames read from sensor
+    uint32_t timeouts(uint8_t sensor); // returns the number of reads of sensor that received nothing
+    uint32_t latency(uint8_t sensor); // returns the micro-seconds taken by the most recent read of sensor
+    uint32_t averageLatency(uint8_t sensor); // returns the average micro-seconds taken by a read of sensor, weighted towards recent reads
+    uint32_t maxLatency(uint8_t sensor); // returns the longest read of sensor, in micro-seconds
+    uint32_t roundTime(); // returns the micro-seconds taken by the most recent round over all sensors
+    uint32_t triggerSkew(); // Synchronized mode. returns the micro-seconds between the first and the last trigger of the most recent slot, 0 for a broadcast.
+    uint32_t slotTime(); // Synchronized mode. returns the micro-seconds between the triggers of the two most recent slots
+    uint32_t minSlotTime(); // Synchronized mode. returns the shortest time measured between the triggers of consecutive slots, in micro-seconds
+  private:
+    void _plan();
+    void _next();
+    void _start();
+    void _trigger(uint8_t slot);
+    Protractor* _sensors[POLLERMAXSENSORS];
+    uint8_t _obs[POLLERMAXSENSORS]; // Objects and paths read from each sensor
+    uint32_t _frames[POLLERMAXSENSORS];
+    uint32_t _timeouts[POLLERMAXSENSORS];
+    uint32_t _latency[POLLERMAXSENSORS];
+    uint32_t _averageLatency[POLLERMAXSENSORS];
+    uint32_t _maxLatency[POLLERMAXSENSORS];
+    void (*_onFrame)(uint8_t sensor, Protractor &protractor);
+    void (*_onRound)();
+    Protractor* _broadcast; // Triggers every sensor at once, 0 to trigger them in turn
+    uint8_t _count; // Sensors scheduled
+    uint8_t _current; // Position in _order of the sensor being read, or to be read next
+    uint8_t _order[POLLERMAXSENSORS]; // Sensors in the order they are read, by slot in synchronized mode
+    uint8_t _slotOf[POLLERMAXSENSORS];
+    uint8_t _separated[POLLERMAXSENSORS]; // Bit n is set if the sensor must not scan together with sensor n
+    uint8_t _slots;
+    bool _running; // A read of _current is on its way
+    bool _begun; // The first round has started
+    bool _synchronized; // Sensors scan when triggered, one slot at a time
+    uint8_t _nextSlot; // Slot to trigger next
+    uint8_t _scanned; // Bit n is set while slot n has been triggered and not all of its frames are collected
+    unsigned long _slotTrigger[POLLERMAXSENSORS]; // micros() when each slot was last triggered
+    unsigned long _lastTrigger; // micros() when the most recent slot was triggered
+    uint32_t _triggerSkew;
+    uint32_t _slotTime;
+    uint32_t _minSlotTime;
+    bool _slotTimed; // A slot has been triggered since synchronize(), so the next trigger can be timed
+    unsigned long _requestTime; // micros() when the running read was requested
+    unsigned long _roundStart; // micros() when the current round began
+    uint32_t _roundTime;
+};
+
+#endif
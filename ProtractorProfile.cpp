@@ -0,0 +1,121 @@
+/*
+  ProtractorProfile.cpp - Stored settings for the Protractor Sensor
+  Copyright (c) 2017 William Moore.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "Arduino.h"
+#include "ProtractorProfile.h"
+#include "ProtractorLog.h"
+#if defined(__AVR__)
+#include <avr/eeprom.h>
+#endif
+
+// A profile holding the Protractor's power-up defaults
+ProtractorProfile::ProtractorProfile()
+{
+  scanTime = MINDUR;
+  ledMode = SHOWOBJ;
+  comm = I2CCOMM;
+  address = DEFAULTADDR;
+  baudRate = 9600;
+  mountYaw = 0;
+  angleOffset = 0;
+}
+
+// returns true if every setting is within the range accepted by the Protractor
+bool ProtractorProfile::valid() const {
+  if(scanTime < 0) return false;
+  if(ledMode != SHOWOBJ && ledMode != SHOWPATH && ledMode != LEDOFF) return false;
+  if(comm != I2CCOMM && comm != SERIALCOMM) return false;
+  if(address < 2 || address > 127) return false;
+  if(baudRate < 1200 || baudRate > 250000) return false;
+  return true;
+}
+
+// Converts a sensor angle (0 to 180, 90 = straight out of the sensor) to degrees relative to the front of the robot.
+int16_t ProtractorProfile::robotAngle(int16_t sensorAngle) const {
+  if(sensorAngle < 0) return sensorAngle;
+  int16_t angle = sensorAngle + (int16_t)angleOffset*180/255 - 90 + mountYaw;
+  while(angle >= 180) angle -= 360;
+  while(angle < -180) angle += 360;
+  return angle;
+}
+
+/////// STORAGE ///////
+
+// Layout of a stored profile, all values little endian:
+//   [0] PROFILEMAGIC  [1] PROFILEVERSION  [2..3] scanTime  [4] ledMode  [5] comm  [6] address
+//   [7..9] baudRate  [10..11] mountYaw  [12] angleOffset  [13] CRC-8 of bytes 0 to 12
+uint8_t ProtractorProfile::toBytes(uint8_t data[]) const {
+  data[0] = PROFILEMAGIC;
+  data[1] = PROFILEVERSION;
+  data[2] = (uint8_t)(scanTime & 0x00FF);
+  data[3] = (uint8_t)(scanTime >> 8);
+  data[4] = ledMode;
+  data[5] = comm;
+  data[6] = address;
+  data[7] = (uint8_t)(baudRate & 0x00FF);
+  data[8] = (uint8_t)(baudRate >> 8);
+  data[9] = (uint8_t)(baudRate >> 16);
+  data[10] = (uint8_t)(mountYaw & 0x00FF);
+  data[11] = (uint8_t)(mountYaw >> 8);
+  data[12] = (uint8_t)angleOffset;
+  data[13] = ProtractorLog::crc8(data,PROFILESIZE-1);
+  return PROFILESIZE;
+}
+
+// Reads a profile from data[PROFILESIZE]. The profile is left unchanged if the bytes are not a valid stored profile.
+bool ProtractorProfile::fromBytes(const uint8_t data[]) {
+  if(data[0] != PROFILEMAGIC || data[1] != PROFILEVERSION) return false;
+  if(ProtractorLog::crc8(data,PROFILESIZE-1) != data[13]) return false;
+  ProtractorProfile profile;
+  profile.scanTime = (int16_t)(data[2] | (data[3] << 8));
+  profile.ledMode = data[4];
+  profile.comm = data[5];
+  profile.address = data[6];
+  profile.baudRate = (int32_t)data[7] | ((int32_t)data[8] << 8) | ((int32_t)data[9] << 16);
+  profile.mountYaw = (int16_t)(data[10] | (data[11] << 8));
+  profile.angleOffset = (int8_t)data[12];
+  if(!profile.valid()) return false;
+  *this = profile;
+  return true;
+}
+
+// Writes the profile to EEPROM. eeprom_update_block only rewrites bytes that changed, which saves EEPROM wear.
+bool ProtractorProfile::save(uint16_t eepromAddress) const {
+#if defined(__AVR__)
+  uint8_t data[PROFILESIZE];
+  toBytes(data);
+  eeprom_update_block(data,(void*)eepromAddress,PROFILESIZE);
+  return true;
+#else
+  (void)eepromAddress;
+  return false;
+#endif
+}
+
+// Reads the profile from EEPROM
+bool ProtractorProfile::load(uint16_t eepromAddress) {
+#if defined(__AVR__)
+  uint8_t data[PROFILESIZE];
+  eeprom_read_block(data,(const void*)eepromAddress,PROFILESIZE);
+  return fromBytes(data);
+#else
+  (void)eepromAddress;
+  return false;
+#endif
+}
@@ -0,0 +1,62 @@
+/*
+  ProtractorProfile.h - Stored settings for the Protractor Sensor
+  Copyright (c) 2017 William Moore.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+  ###########################################################################
+
+  The Protractor forgets its scan time and LED mode every time it is rebooted. A ProtractorProfile keeps
+  those settings on the host, together with how the sensor is reached (I2C address or Serial baud rate)
+  and how it is mounted on the robot, so that they can be stored once and re-applied at every boot with
+  a single call to Protractor.applyProfile().
+
+  A profile is stored as PROFILESIZE bytes protected by a CRC-8. On AVR boards it can be saved to and
+  loaded from the EEPROM directly. On other boards, or on a PC, the bytes from toBytes() can be written to
+  any file or memory and read back with fromBytes().
+
+  ############################################################################
+*/
+
+#ifndef ProtractorProfile_h
+#define ProtractorProfile_h
+
+#include <inttypes.h>
+#include "Protractor.h"
+
+#define PROFILEMAGIC   0x50 // 'P', first byte of a stored profile
+#define PROFILEVERSION 1
+#define PROFILESIZE    14 // Number of bytes used by a stored profile
+
+class ProtractorProfile
+{
+  public:
+    ProtractorProfile(); // A profile holding the Protractor's power-up defaults
+    int16_t scanTime; // Time between scans in milliSeconds, see Protractor.scanTime(). Default is MINDUR.
+    uint8_t ledMode; // SHOWOBJ, SHOWPATH or LEDOFF. Default is SHOWOBJ.
+    uint8_t comm; // I2CCOMM or SERIALCOMM, how the sensor is expected to be reached
+    uint8_t address; // Expected I2C address. Default is DEFAULTADDR.
+    int32_t baudRate; // Expected Serial baud rate. Default is 9600.
+    int16_t mountYaw; // Direction the sensor faces relative to the front of the robot, in degrees. Positive is to the right.
+    int8_t angleOffset; // Calibration added to the sensor's 0 to 255 angle before it is converted to degrees
+    bool valid() const; // returns true if every setting is within the range accepted by the Protractor
+    int16_t robotAngle(int16_t sensorAngle) const; // Converts an angle from Protractor.objectAngle() or pathAngle() (0 to 180, 90 = straight out of the sensor) to degrees relative to the front of the robot, -180 to 179. Returns sensorAngle if it is -1.
+    uint8_t toBytes(uint8_t data[]) const; // Writes the profile to data[PROFILESIZE]. Returns PROFILESIZE.
+    bool fromBytes(const uint8_t data[]); // Reads a profile from data[PROFILESIZE]. Returns false, and leaves the profile unchanged, if the bytes are not a valid stored profile.
+    bool save(uint16_t eepromAddress) const; // AVR only. Writes the profile to EEPROM, only bytes that changed are written. Returns false on other boards.
+    bool load(uint16_t eepromAddress); // AVR only. Reads the profile from EEPROM. Returns false if no valid profile is stored there, or on other boards.
+};
+
+#endif
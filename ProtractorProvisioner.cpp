@@ -0,0 +1,147 @@
+/*
+  ProtractorProvisioner.cpp - I2C bus discovery and address provisioning for the Protractor Sensor
+  Copyright (c) 2017 William Moore.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "Arduino.h"
+#include "ProtractorProvisioner.h"
+
+ProtractorProvisioner::ProtractorProvisioner()
+{
+  _wire = 0;
+  _bootTime = BOOTTIME;
+  _collisions = 0;
+}
+
+// Initialize the provisioner on an I2C bus
+void ProtractorProvisioner::begin(TwoWire &wire)
+{
+  _wire = &wire;
+  _wire->begin();
+}
+
+// Time to wait after powering a sensor before talking to it
+void ProtractorProvisioner::bootTime(uint16_t milliSeconds)
+{
+  _bootTime = milliSeconds;
+}
+
+/////// DISCOVERY ///////
+
+// Reads PROBESAMPLES full frames from address and classifies whatever answered.
+// Only reads are issued, so a foreign device on the bus is never sent a command.
+uint8_t ProtractorProvisioner::probe(uint8_t address) {
+  uint8_t frame[1+4*MAXOBJECTS];
+  uint8_t numBytes = 1+4*MAXOBJECTS;
+  uint8_t good = 0;
+  uint8_t bad = 0;
+  for(uint8_t s = 0; s < PROBESAMPLES; s++){
+    if(s > 0) delay(MINDUR); // Give the sensor time to complete a new scan so every sample is a different frame
+    _wire->requestFrom(address, numBytes);
+    uint8_t i = 0;
+    while(_wire->available()){
+      uint8_t data = _wire->read();
+      if(i < numBytes) frame[i++] = data;
+    }
+    if(i == 0){
+      if(s == 0) return PROBE_EMPTY; // Nothing acknowledged the address
+      bad++;
+    }else if(i == numBytes && Protractor::validFrame(frame,numBytes)){
+      good++;
+    }else{
+      bad++;
+    }
+  }
+  if(good == 0) return PROBE_OTHER;
+  if(bad > 0) return PROBE_COLLISION;
+  return PROBE_PROTRACTOR;
+}
+
+// Probes addresses 2 to 127 and stores the addresses of Protractor-like responders in found[].
+uint8_t ProtractorProvisioner::scan(uint8_t found[], uint8_t maxFound) {
+  uint8_t numFound = 0;
+  _collisions = 0;
+  for(uint8_t address = 2; address <= 127; address++){
+    uint8_t result = probe(address);
+    if(result == PROBE_COLLISION) _collisions++;
+    if((result == PROBE_PROTRACTOR || result == PROBE_COLLISION) && numFound < maxFound){
+      found[numFound] = address;
+      numFound++;
+    }
+  }
+  return numFound;
+}
+
+// Number of addresses that probed as PROBE_COLLISION during the most recent scan()
+uint8_t ProtractorProvisioner::collisions() {
+  return _collisions;
+}
+
+/////// PROVISIONING ///////
+
+// Moves sensors 0 to count-1 from startAddress to newAddresses[sensor], one at a time.
+// All sensors are switched off first. Each sensor is then switched on alone, readdressed, reset and verified,
+// and left running on its new address so that it is seen as taken by the sensors that follow.
+// A sensor that keeps startAddress would leave it taken for every sensor after it, so those go last.
+uint8_t ProtractorProvisioner::provision(uint8_t count, const uint8_t newAddresses[], uint8_t results[], void (*power)(uint8_t sensor, bool on), uint8_t startAddress) {
+  for(uint8_t sensor = 0; sensor < count; sensor++){
+    power(sensor,false);
+  }
+  delay(OFFTIME);
+  uint8_t numProvisioned = 0;
+  for(uint8_t keeping = 0; keeping < 2; keeping++){ // First the sensors that move, then those that keep startAddress
+    for(uint8_t sensor = 0; sensor < count; sensor++){
+      if((newAddresses[sensor] == startAddress) != (keeping == 1)) continue;
+      results[sensor] = _provisionOne(sensor,newAddresses[sensor],power,startAddress);
+      if(results[sensor] == PROVISION_OK || results[sensor] == PROVISION_ALREADY) numProvisioned++;
+    }
+  }
+  return numProvisioned;
+}
+
+/////// PRIVATE FUNCTIONS ///////
+
+uint8_t ProtractorProvisioner::_provisionOne(uint8_t sensor, uint8_t newAddress, void (*power)(uint8_t sensor, bool on), uint8_t startAddress) {
+  if(newAddress < 2 || newAddress > 127) return PROVISION_BAD_ADDRESS;
+
+  // With this sensor still off, anything on the start address is a sensor we do not control,
+  // and anything on the new address is another device.
+  if(probe(startAddress) != PROBE_EMPTY) return PROVISION_COLLISION;
+  if(newAddress != startAddress && probe(newAddress) != PROBE_EMPTY) return PROVISION_ADDRESS_TAKEN;
+
+  power(sensor,true);
+  delay(_bootTime);
+  uint8_t found = probe(startAddress);
+  if(found == PROBE_COLLISION) return PROVISION_COLLISION;
+  if(found != PROBE_PROTRACTOR){
+    if(newAddress != startAddress && probe(newAddress) == PROBE_PROTRACTOR) return PROVISION_ALREADY; // Provisioned on an earlier run
+    return PROVISION_NOT_FOUND;
+  }
+  if(newAddress == startAddress) return PROVISION_ALREADY;
+
+  Protractor protractor;
+  protractor.begin(*_wire,startAddress);
+  protractor.setNewI2Caddress(newAddress);
+
+  // The new address takes effect after a reset
+  power(sensor,false);
+  delay(OFFTIME);
+  power(sensor,true);
+  delay(_bootTime);
+  if(probe(newAddress) == PROBE_PROTRACTOR && probe(startAddress) == PROBE_EMPTY) return PROVISION_OK;
+  return PROVISION_VERIFY_FAILED;
+}
@@ -0,0 +1,76 @@
+/*
+  ProtractorProvisioner.h - I2C bus discovery and address provisioning for the Protractor Sensor
+  Copyright (c) 2017 William Moore.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+  ###########################################################################
+
+  Every Protractor leaves the factory on I2C address 0x45 (69d). Bringing up a robot with several sensors
+  means moving all but one of them to a unique address, and a new address only takes effect after the
+  sensor is reset. The ProtractorProvisioner scans a bus for Protractor-like responders, flags addresses
+  where two sensors appear to answer at once, and walks a list of sensors through address assignment one
+  at a time, verifying each sensor at its new address before moving on to the next.
+
+  Sensors are brought up one at a time through a callback supplied by the sketch, typically driving a
+  transistor on each sensor's Vin or a GPIO on its reset line.
+
+  ############################################################################
+*/
+
+#ifndef ProtractorProvisioner_h
+#define ProtractorProvisioner_h
+
+#include <Wire.h>
+#include <inttypes.h>
+#include "Protractor.h"
+
+// Results of probing a single I2C address
+#define PROBE_EMPTY      0 // Nothing acknowledged the address
+#define PROBE_PROTRACTOR 1 // A single Protractor answered with well-formed frames
+#define PROBE_OTHER      2 // Something answered, but its data does not look like a Protractor frame
+#define PROBE_COLLISION  3 // Protractor frames were seen, but some were malformed. Most likely two sensors share the address.
+
+// Results of provisioning a single sensor
+#define PROVISION_OK            0 // Sensor moved to its new address and verified
+#define PROVISION_ALREADY       1 // Sensor was already answering on its new address
+#define PROVISION_NOT_FOUND     2 // Nothing answered on the start address after the sensor was powered
+#define PROVISION_COLLISION     3 // More than one sensor answered on the start address
+#define PROVISION_ADDRESS_TAKEN 4 // Another device already answers on the requested new address
+#define PROVISION_VERIFY_FAILED 5 // Sensor did not show up on its new address after reset
+#define PROVISION_BAD_ADDRESS   6 // Requested new address is outside of 2 to 127
+
+#define PROBESAMPLES 3 // Number of frames read from an address before deciding what answered
+#define BOOTTIME   500 // Milli-seconds to wait for a sensor to start answering after it is powered
+#define OFFTIME     50 // Milli-seconds a sensor is held off when it is reset
+
+class ProtractorProvisioner
+{
+  public:
+    ProtractorProvisioner();
+    void begin(TwoWire &wire); // Initialize the provisioner on an I2C bus
+    uint8_t probe(uint8_t address); // Reads a few frames from address and classifies the responder. Returns PROBE_EMPTY, PROBE_PROTRACTOR, PROBE_OTHER or PROBE_COLLISION. Never writes to the bus.
+    uint8_t scan(uint8_t found[], uint8_t maxFound); // Probes addresses 2 to 127 and stores the addresses of Protractor-like responders in found[]. Returns the number of Protractors found, up to maxFound. Addresses that probe as PROBE_COLLISION are included; check collisions() afterwards.
+    uint8_t collisions(); // Number of addresses that probed as PROBE_COLLISION during the most recent scan()
+    uint8_t provision(uint8_t count, const uint8_t newAddresses[], uint8_t results[], void (*power)(uint8_t sensor, bool on), uint8_t startAddress = DEFAULTADDR); // Moves sensors 0 to count-1 from startAddress to newAddresses[sensor], one at a time, those that keep startAddress last. power(sensor,on) switches a single sensor on or off. Stores a PROVISION_ result for each sensor in results[]. Returns the number of sensors that ended up on their new address.
+    void bootTime(uint16_t milliSeconds); // Time to wait after powering a sensor before talking to it. Default is BOOTTIME.
+  private:
+    uint8_t _provisionOne(uint8_t sensor, uint8_t newAddress, void (*power)(uint8_t sensor, bool on), uint8_t startAddress);
+    TwoWire* _wire; // Handle for the TwoWire object (i2c) the sensors are attached to
+    uint16_t _bootTime; // Milli-seconds to wait for a sensor to boot
+    uint8_t _collisions; // Collisions counted during the most recent scan
+};
+
+#endif
@@ -0,0 +1,114 @@
+/*
+  ProtractorRecorder.cpp - Binary frame recorder for the Protractor Sensor
+  Copyright (c) 2017 William Moore.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "Arduino.h"
+#include "ProtractorRecorder.h"
+
+ProtractorRecorder::ProtractorRecorder()
+{
+  _sink = 0;
+  _sequence = 0;
+  _dropped = 0;
+}
+
+// Start a new log on sink by writing the log header
+bool ProtractorRecorder::begin(Print &sink)
+{
+  _sink = &sink;
+  _sequence = 0;
+  _dropped = 0;
+  uint8_t header[LOGHEADERSIZE];
+  ProtractorLog::writeHeader(header);
+  return _sink->write(header,LOGHEADERSIZE) == LOGHEADERSIZE;
+}
+
+// Appends the most recent frame read by protractor
+bool ProtractorRecorder::record(Protractor &protractor) {
+  return record(protractor.frameData(),protractor.frameLength(),micros());
+}
+
+// Appends length bytes of frame with the given timestamp. The record is assembled first and handed to the
+// sink in a single write, so a full sink never receives half a record.
+bool ProtractorRecorder::record(const uint8_t frame[], uint8_t length, uint32_t timestamp) {
+  if(_sink == 0) return 0;
+  ProtractorLogRecord entry;
+  entry.sequence = _sequence;
+  entry.timestamp = timestamp;
+  entry.length = length > LOGMAXFRAME ? LOGMAXFRAME : length;
+  memcpy(entry.frame,frame,entry.length);
+  uint8_t data[LOGRECORDSIZE+LOGMAXFRAME];
+  uint8_t size = ProtractorLog::writeRecord(entry,data);
+  _sequence++; // Counted even when dropped, so readers see the gap
+  if(_sink->write(data,size) != size){
+    _dropped++;
+    return 0;
+  }
+  return 1;
+}
+
+// returns the number of records appended since begin()
+uint32_t ProtractorRecorder::count() {
+  return _sequence;
+}
+
+// returns the number of records the sink did not fully accept
+uint32_t ProtractorRecorder::dropped() {
+  return _dropped;
+}
+
+// Pushes buffered data out to the sink
+void ProtractorRecorder::flush() {
+  if(_sink != 0) _sink->flush();
+}
+
+/////// MEMORY LOG ///////
+
+ProtractorMemoryLog::ProtractorMemoryLog(uint8_t buffer[], uint32_t capacity)
+{
+  _buffer = buffer;
+  _capacity = capacity;
+  _length = 0;
+}
+
+size_t ProtractorMemoryLog::write(uint8_t data) {
+  return write(&data,1);
+}
+
+// Stores all of buffer, or nothing if it does not fit
+size_t ProtractorMemoryLog::write(const uint8_t *buffer, size_t size) {
+  if(size > _capacity - _length) return 0;
+  memcpy(_buffer+_length,buffer,size);
+  _length += size;
+  return size;
+}
+
+// returns the start of the buffer
+const uint8_t* ProtractorMemoryLog::data() {
+  return _buffer;
+}
+
+// returns the number of bytes stored
+uint32_t ProtractorMemoryLog::length() {
+  return _length;
+}
+
+// Empties the buffer
+void ProtractorMemoryLog::clear() {
+  _length = 0;
+}
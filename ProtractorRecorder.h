@@ -0,0 +1,69 @@
+/*
+  ProtractorRecorder.h - Binary frame recorder for the Protractor Sensor
+  Copyright (c) 2017 William Moore.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+  ###########################################################################
+
+  The ProtractorRecorder appends every frame returned by Protractor.read() to a binary frame log (see
+  ProtractorLog.h) so that what the sensor saw in the field can be examined, or replayed, afterwards.
+  The log is written to any Print: an SD card File, a Serial port, or a ProtractorMemoryLog that keeps
+  the log in a RAM buffer.
+
+  ############################################################################
+*/
+
+#ifndef ProtractorRecorder_h
+#define ProtractorRecorder_h
+
+#include <Arduino.h>
+#include <inttypes.h>
+#include "Protractor.h"
+#include "ProtractorLog.h"
+
+class ProtractorRecorder
+{
+  public:
+    ProtractorRecorder();
+    bool begin(Print &sink); // Start a new log on sink by writing the log header. Returns false if the sink did not accept it.
+    bool record(Protractor &protractor); // Appends the most recent frame read by protractor, timestamped with micros(). Call right after read(). Returns false if the sink did not accept the whole record.
+    bool record(const uint8_t frame[], uint8_t length, uint32_t timestamp); // Appends length bytes of frame with the given timestamp
+    uint32_t count(); // returns the number of records appended since begin()
+    uint32_t dropped(); // returns the number of records the sink did not fully accept, e.g. because the SD card is full
+    void flush(); // Pushes buffered data out to the sink, e.g. writes an SD card File's buffer to the card
+  private:
+    Print* _sink; // Where the log is written
+    uint32_t _sequence; // Sequence number of the next record
+    uint32_t _dropped; // Records not fully accepted by the sink
+};
+
+// A Print that keeps a log in a RAM buffer supplied by the sketch. Writes that do not fit are refused.
+class ProtractorMemoryLog : public Print
+{
+  public:
+    ProtractorMemoryLog(uint8_t buffer[], uint32_t capacity);
+    virtual size_t write(uint8_t data);
+    virtual size_t write(const uint8_t *buffer, size_t size);
+    const uint8_t* data(); // returns the start of the buffer
+    uint32_t length(); // returns the number of bytes stored
+    void clear(); // Empties the buffer
+  private:
+    uint8_t* _buffer;
+    uint32_t _capacity;
+    uint32_t _length;
+};
+
+#endif
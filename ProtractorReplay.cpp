@@ -0,0 +1,161 @@
+/*
+  ProtractorReplay.cpp - Plays a recorded frame log back to the Protractor library
+  Copyright (c) 2017 William Moore.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "Arduino.h"
+#include "ProtractorReplay.h"
+
+ProtractorReplayStream::ProtractorReplayStream()
+{
+  _log = 0;
+  _size = 0;
+  _speed = 0;
+  rewind();
+}
+
+// Play the log held in log[size]
+bool ProtractorReplayStream::begin(const uint8_t log[], uint32_t size, uint16_t speed)
+{
+  _log = log;
+  _size = size;
+  _speed = speed;
+  rewind();
+  if(size < LOGHEADERSIZE || !ProtractorLog::checkHeader(log)){
+    _size = 0;
+    return 0;
+  }
+  return 1;
+}
+
+// Start playing from the first record again
+void ProtractorReplayStream::rewind() {
+  _position = LOGHEADERSIZE;
+  _pending = false;
+  _length = 0;
+  _index = 0;
+  _started = false;
+  _commandLength = 0;
+  _played = 0;
+  _skipped = 0;
+}
+
+// returns true once every record has been handed out
+bool ProtractorReplayStream::finished() {
+  return !_pending && _position >= _size;
+}
+
+uint32_t ProtractorReplayStream::played() {
+  return _played;
+}
+
+uint32_t ProtractorReplayStream::skipped() {
+  return _skipped;
+}
+
+uint32_t ProtractorReplayStream::timestamp() {
+  return _record.timestamp;
+}
+
+/////// STREAM ///////
+
+int ProtractorReplayStream::available() {
+  if(!_pending) return 0;
+  return _length - _index;
+}
+
+int ProtractorReplayStream::read() {
+  if(available() == 0) return -1;
+  uint8_t data = _record.frame[_index];
+  _index++;
+  if(_index >= _length) _pending = false;
+  return data;
+}
+
+int ProtractorReplayStream::peek() {
+  if(available() == 0) return -1;
+  return _record.frame[_index];
+}
+
+// Collects the commands written by Protractor. A REQUESTDATA command hands out the next record. Other commands are ignored.
+size_t ProtractorReplayStream::write(uint8_t data) {
+  _command[_commandLength] = data;
+  _commandLength++;
+  uint8_t size = _commandSize();
+  if(size == 0){ // Not the start of a command. Dropped, so the next byte can start one.
+    _commandLength = 0;
+  }else if(_commandLength >= size){
+    if(_command[0] == REQUESTDATA && _command[2] == '\n') _request(_command[1]);
+    _commandLength = 0;
+  }
+  return 1;
+}
+
+size_t ProtractorReplayStream::write(const uint8_t *buffer, size_t size) {
+  for(size_t i = 0; i < size; i++) write(buffer[i]);
+  return size;
+}
+
+/////// PRIVATE FUNCTIONS ///////
+
+// Moves on to the next record. When paced, the current record is handed out again until the next one is due.
+void ProtractorReplayStream::_request(uint8_t numBytes) {
+  if(!_started || _speed == 0 || _due()){
+    uint32_t skipped;
+    uint32_t used = _position < _size ? ProtractorLog::readRecord(_log+_position,_size-_position,_record,skipped) : 0;
+    if(used == 0){
+      _position = _size; // Nothing but a damaged tail left
+      _pending = false;
+      return;
+    }
+    _position += used;
+    _skipped += skipped;
+    _played++;
+    if(!_started){
+      _started = true;
+      _firstTimestamp = _record.timestamp;
+      _startMicros = micros();
+    }
+  }
+  _pending = true;
+  _index = 0;
+  _length = _record.length < numBytes ? _record.length : numBytes;
+  if(_length == 0) _pending = false; // The sensor did not answer this time
+}
+
+// returns true once the record after the current one is due, or there is none left
+bool ProtractorReplayStream::_due() {
+  ProtractorLogRecord next;
+  uint32_t skipped;
+  if(_position >= _size || ProtractorLog::readRecord(_log+_position,_size-_position,next,skipped) == 0) return 1;
+  return (uint32_t)(micros() - _startMicros) >= (next.timestamp - _firstTimestamp) / _speed;
+}
+
+// returns the length of the command in _command, its '\n' included, once enough of it has arrived to tell. 0 if _command[0] starts no command.
+uint8_t ProtractorReplayStream::_commandSize() {
+  switch(_command[0]){
+    case REQUESTDATA:
+    case I2CADDR:
+    case LEDUSAGE:
+      return 3;
+    case SCANTIME: // Two bytes of milli-seconds, or a single MINDUR byte
+      return _commandLength == 3 && _command[1] == MINDUR && _command[2] == '\n' ? 3 : 4;
+    case BAUDRATE:
+      return 5;
+  }
+  return 0;
+}
@@ -0,0 +1,84 @@
+/*
+  ProtractorReplay.h - Plays a recorded frame log back to the Protractor library
+  Copyright (c) 2017 William Moore.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+  ###########################################################################
+
+  A ProtractorReplayStream stands in for the Serial port a Protractor is attached to. Pass it to
+  Protractor.begin() and every read() receives the next frame of a log made by ProtractorRecorder, through
+  the same code that reads a real sensor. Strategy code can then be run again and again against what the
+  robot saw in the field, on the robot or on a PC (see extras/host).
+
+  By default each request is answered at once with the next record, so every read() gets the next frame
+  however far apart the frames were recorded. Real-time pacing is asked for with speed = 1, or speed = N
+  to play N times faster: a record then becomes due at its recorded time, relative to the first request,
+  and a request made before the next record is due is answered with the current record again, as the
+  sensor answers with its latest scan. Either way a read only times out where the recorded sensor did
+  not answer.
+
+  Commands are told apart by their code and length, as the sensor does, since their values can hold any
+  byte, '\n' included. Only REQUESTDATA is acted on; the rest are skipped.
+
+  ############################################################################
+*/
+
+#ifndef ProtractorReplay_h
+#define ProtractorReplay_h
+
+#include <Arduino.h>
+#include <inttypes.h>
+#include "Protractor.h"
+#include "ProtractorLog.h"
+
+class ProtractorReplayStream : public Stream
+{
+  public:
+    ProtractorReplayStream();
+    bool begin(const uint8_t log[], uint32_t size, uint16_t speed = 0); // Play the log held in log[size]. speed 0 answers each request with the next record, N paces records at N times their recorded timing. Returns false if it does not start with a valid log header.
+    void rewind(); // Start playing from the first record again
+    bool finished(); // returns true once every record has been handed out
+    uint32_t played(); // returns the number of records handed out
+    uint32_t skipped(); // returns the number of damaged log bytes skipped
+    uint32_t timestamp(); // returns the recorded timestamp of the current record
+    virtual int available();
+    virtual int read();
+    virtual int peek();
+    virtual size_t write(uint8_t data); // Receives the commands sent by Protractor
+    virtual size_t write(const uint8_t *buffer, size_t size);
+    using Print::write;
+  private:
+    void _request(uint8_t numBytes);
+    bool _due();
+    uint8_t _commandSize();
+    const uint8_t* _log; // Log being played
+    uint32_t _size; // Size of the log in bytes
+    uint32_t _position; // Offset of the next record in the log
+    uint16_t _speed; // Playback speed, 0 = no pacing
+    ProtractorLogRecord _record; // Record being played
+    bool _pending; // True while _record is waiting to be read
+    uint8_t _length; // Number of bytes of _record to hand out
+    uint8_t _index; // Next byte of _record to hand out
+    bool _started; // True once the first frame was requested
+    uint32_t _firstTimestamp; // Recorded timestamp of the first record
+    uint32_t _startMicros; // micros() at the first request
+    uint8_t _command[5]; // Command being received from Protractor
+    uint8_t _commandLength;
+    uint32_t _played;
+    uint32_t _skipped;
+};
+
+#endif
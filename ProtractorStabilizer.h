@@ -0,0 +1,139 @@
+/*
+  ProtractorStabilizer.h - Steadies the counts and angles of Protractor frames
+  Copyright (c) 2017 William Moore.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+  ###########################################################################
+
+  An object at the edge of detection comes and goes from one frame to the next, and now and then a frame
+  puts an object or path far from where it was a frame before and after. A robot steering on every frame
+  jerks at each. A ProtractorStabilizer is fed every frame and reports what has held still long enough:
+
+    ProtractorStabilizer<3> stable; // Median of 3 frames per slot
+
+    if(protractor.read()) stable.update(protractor.frame(), protractor.frameLength());
+    if(stable.objectCount() > 0) steerToward(stable.objectAngle(0));
+
+  Counts have hysteresis. A higher count is only reported once it has been received in riseFrames frames
+  in a row, and a lower count once in fallFrames in a row, the lowest or highest seen in that run, so a
+  slot flickering at the edge keeps its last state. Angles are the median of each slot's last N angles,
+  which passes a steady or turning angle through and drops a spike of up to N/2 frames. Each slot also
+  counts the frames in a row it has been received, for a sketch that only trusts an object seen for a
+  while.
+
+  Slots are ranks, as in the frame: object 0 is the most visible object, whichever it is. update() does
+  the same work for every frame, N compares and moves per slot, whatever the frame holds.
+
+  ############################################################################
+*/
+
+#ifndef ProtractorStabilizer_h
+#define ProtractorStabilizer_h
+
+#include <inttypes.h>
+#include "ProtractorFrame.h"
+#include "ProtractorFilter.h"
+
+template<uint8_t N = 3, uint8_t POINTS = MAXOBJECTS>
+class ProtractorStabilizer
+{
+  static_assert(POINTS >= 1 && POINTS <= MAXOBJECTS, "a frame holds 1 to MAXOBJECTS data points");
+  public:
+    ProtractorStabilizer() { _objects.rise = _paths.rise = 2; _objects.fall = _paths.fall = 2; clear(); }
+    void hysteresis(uint8_t riseFrames, uint8_t fallFrames) { // Frames in a row a higher or a lower count must be received before it is reported. 1 for no hysteresis. Default is 2 and 2.
+      _objects.rise = _paths.rise = riseFrames > 0 ? riseFrames : 1;
+      _objects.fall = _paths.fall = fallFrames > 0 ? fallFrames : 1;
+    }
+    void clear() { _objects.clear(); _paths.clear(); } // Forgets every frame, as after the sensor was moved
+    template<uint8_t P>
+    void update(const ProtractorFrameOf<P> &frame, uint8_t length) { // Call with each frame read and its length, such as Protractor.frame() and Protractor.frameLength()
+      uint8_t objects = frame.objectsReceived(length);
+      uint8_t paths = frame.pathsReceived(length);
+      _objects.update(frame.data + 1, objects < POINTS ? objects : POINTS);
+      _paths.update(frame.data + 3, paths < POINTS ? paths : POINTS);
+    }
+    int16_t objectCount() const { return _objects.count; } // returns the number of objects, after hysteresis
+    int16_t pathCount() const { return _paths.count; } // returns the number of paths, after hysteresis
+    int16_t objectAngleRaw(int16_t ob = 0) const { return _objects.angle(ob); } // returns the median angle byte of object ob, -1 if ob is not counted
+    int16_t pathAngleRaw(int16_t pa = 0) const { return _paths.angle(pa); } // returns the median angle byte of path pa, -1 if pa is not counted
+    int16_t objectAngle(int16_t ob = 0) const { return toDegrees(_objects.angle(ob)); } // returns the median angle to object ob in degrees, -1 if ob is not counted
+    int16_t pathAngle(int16_t pa = 0) const { return toDegrees(_paths.angle(pa)); } // returns the median angle to path pa in degrees, -1 if pa is not counted
+    int16_t objectVisibility(int16_t ob = 0) const { return _objects.visibility(ob); } // returns the visibility of object ob when last received, -1 if ob is not counted
+    int16_t pathVisibility(int16_t pa = 0) const { return _paths.visibility(pa); } // returns the visibility of path pa when last received, -1 if pa is not counted
+    uint8_t objectPersistence(int16_t ob = 0) const { return _objects.persistence(ob); } // returns the frames in a row object ob has been received, up to 255. 0 if it was missing from the latest frame.
+    uint8_t pathPersistence(int16_t pa = 0) const { return _paths.persistence(pa); } // returns the frames in a row path pa has been received, up to 255. 0 if it was missing from the latest frame.
+  private:
+    static int16_t toDegrees(int16_t angle) { return angle < 0 ? -1 : ProtractorFrame::toDegrees((uint8_t)angle); }
+
+    // The objects or the paths of the frames
+    struct Track
+    {
+      uint8_t count; // Reported count
+      uint8_t pending; // Count waiting out the hysteresis
+      uint8_t pendingFrames; // Frames in a row the received count has been on the same side of count
+      uint8_t rise;
+      uint8_t fall;
+      uint8_t frames[POINTS]; // Frames in a row each slot has been received
+      uint8_t visibilities[POINTS];
+      ProtractorMedian<N> angles[POINTS];
+
+      void clear() {
+        count = 0;
+        pending = 0;
+        pendingFrames = 0;
+        for(uint8_t i = 0; i < POINTS; i++) {
+          frames[i] = 0;
+          visibilities[i] = 0;
+          angles[i].clear();
+        }
+      }
+      // point points at the angle byte of slot 0; slots follow every 4 bytes
+      void update(const uint8_t *point, uint8_t received) {
+        for(uint8_t i = 0; i < POINTS; i++, point += 4) {
+          if(i >= received) {
+            frames[i] = 0;
+            continue;
+          }
+          if(frames[i] == 0 && i >= count) angles[i].clear(); // A slot coming back after it stopped being counted starts afresh
+          if(frames[i] < 255) frames[i]++;
+          angles[i].add(point[0]);
+          visibilities[i] = point[1];
+        }
+        if(received == count) {
+          pendingFrames = 0;
+          return;
+        }
+        bool up = received > count;
+        if(pendingFrames == 0 || (pending > count) != up) { // A new run away from count
+          pending = received;
+          pendingFrames = 0;
+        } else if(up ? received < pending : received > pending) { // The count of the run closest to count
+          pending = received;
+        }
+        if(++pendingFrames >= (up ? rise : fall)) {
+          count = pending;
+          pendingFrames = 0;
+        }
+      }
+      int16_t angle(int16_t i) const { return i < 0 || i >= count || angles[i].count() == 0 ? -1 : angles[i].median(); }
+      int16_t visibility(int16_t i) const { return i < 0 || i >= count ? -1 : visibilities[i]; }
+      uint8_t persistence(int16_t i) const { return i < 0 || i >= POINTS ? 0 : frames[i]; }
+    };
+    Track _objects;
+    Track _paths;
+};
+
+#endif
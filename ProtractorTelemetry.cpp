@@ -0,0 +1,112 @@
+/*
+  ProtractorTelemetry.cpp - Non-blocking binary telemetry of Protractor frames
+  Copyright (c) 2017 William Moore.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "Arduino.h"
+#include "ProtractorTelemetry.h"
+#include "ProtractorLog.h"
+
+ProtractorTelemetry::ProtractorTelemetry(uint8_t keyframeInterval) : _encoder(keyframeInterval)
+{
+  _port = 0;
+  _head = 0;
+  _count = 0;
+  _dropped = 0;
+}
+
+// Send telemetry to port
+void ProtractorTelemetry::begin(Print &port)
+{
+  _port = &port;
+  _head = 0;
+  _count = 0;
+  _dropped = 0;
+  _encoder.reset();
+}
+
+// Queues the most recent frame read by protractor
+bool ProtractorTelemetry::send(Protractor &protractor) {
+  return send(protractor.frameData(),protractor.frameLength());
+}
+
+// Queues length bytes of frame. The packet is assembled first and only queued if all of it fits.
+bool ProtractorTelemetry::send(const uint8_t frame[], uint8_t length) {
+  uint8_t packet[TELEMETRYMAXPACKET];
+  uint8_t size = _encoder.encode(frame,length,packet+4);
+  uint16_t time = (uint16_t)millis();
+  packet[0] = TELEMETRYSYNC;
+  packet[1] = size;
+  packet[2] = (uint8_t)time;
+  packet[3] = (uint8_t)(time >> 8);
+  packet[4+size] = ProtractorLog::crc8(packet+1,3+size);
+  size += 5;
+  if(size > TELEMETRYBUFFER - _count){
+    _dropped++;
+    _encoder.reset(); // The receiver misses this delta, so the next frame has to stand on its own
+    return 0;
+  }
+  uint8_t tail = _head + _count;
+  for(uint8_t i = 0; i < size; i++){
+    if(tail >= TELEMETRYBUFFER) tail -= TELEMETRYBUFFER;
+    _buffer[tail] = packet[i];
+    tail++;
+  }
+  _count += size;
+  update();
+  return 1;
+}
+
+// Hands the port as many queued bytes as it can take without blocking
+void ProtractorTelemetry::update() {
+  if(_port == 0 || _count == 0) return;
+  int space = _port->availableForWrite();
+  if(space <= 0) return;
+  _drain(space > _count ? _count : (uint8_t)space);
+}
+
+// Writes everything queued
+void ProtractorTelemetry::flush() {
+  if(_port == 0) return;
+  _drain(_count);
+}
+
+// returns the number of bytes waiting to be sent
+uint8_t ProtractorTelemetry::queued() {
+  return _count;
+}
+
+// returns the number of frames dropped because the queue was full
+uint32_t ProtractorTelemetry::dropped() {
+  return _dropped;
+}
+
+/////// PRIVATE FUNCTIONS ///////
+
+// Writes limit bytes from the ring buffer, in at most two pieces when it wraps around
+void ProtractorTelemetry::_drain(uint8_t limit) {
+  while(limit > 0){
+    uint8_t piece = TELEMETRYBUFFER - _head;
+    if(piece > limit) piece = limit;
+    uint8_t written = _port->write(_buffer+_head,piece);
+    _head += written;
+    if(_head >= TELEMETRYBUFFER) _head -= TELEMETRYBUFFER;
+    _count -= written;
+    limit -= written;
+    if(written < piece) return; // Port refused the rest
+  }
+}
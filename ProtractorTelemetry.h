@@ -0,0 +1,69 @@
+/*
+  ProtractorTelemetry.h - Non-blocking binary telemetry of Protractor frames
+  Copyright (c) 2017 William Moore.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+  ###########################################################################
+
+  Printing every frame as text with Serial.print() takes tens of milli-seconds at 9600 baud, and the loop
+  stops until the last character is out. ProtractorTelemetry instead compresses each frame with a
+  ProtractorFrameEncoder, queues the packet in a small ring buffer, and on every update() hands the port
+  only as many bytes as its transmit buffer can take without waiting. When the ring buffer is full the
+  frame is dropped rather than stalling the loop, and the next frame is sent as a keyframe.
+
+  Each packet is sent as:
+    [0] TELEMETRYSYNC   [1] size   [2..3] millis() low 16 bits   [4..] size bytes of codec packet   [last] CRC-8
+
+  where the CRC-8 covers bytes 1 onwards. The extras/host folder has protractor_telemetry, which
+  rebuilds the frames on a PC.
+
+  ############################################################################
+*/
+
+#ifndef ProtractorTelemetry_h
+#define ProtractorTelemetry_h
+
+#include <Arduino.h>
+#include <inttypes.h>
+#include "Protractor.h"
+#include "ProtractorCodec.h"
+
+#define TELEMETRYSYNC   0x7E
+#define TELEMETRYBUFFER 64 // Bytes queued for the port. Holds at least two packets of any size.
+#define TELEMETRYMAXPACKET (5+CODECMAXPACKET) // Sync, size, time, codec packet and CRC
+
+class ProtractorTelemetry
+{
+  public:
+    ProtractorTelemetry(uint8_t keyframeInterval = 16);
+    void begin(Print &port); // Send telemetry to port, e.g. Serial or a radio module's Serial
+    bool send(Protractor &protractor); // Queues the most recent frame read by protractor. Returns false if the queue was full and the frame was dropped.
+    bool send(const uint8_t frame[], uint8_t length); // Queues length bytes of frame
+    void update(); // Hands the port as many queued bytes as it can take without blocking. Call once per loop.
+    void flush(); // Writes everything queued, waiting if needed. Use with ports that do not report availableForWrite(), such as SoftwareSerial.
+    uint8_t queued(); // returns the number of bytes waiting to be sent
+    uint32_t dropped(); // returns the number of frames dropped because the queue was full
+  private:
+    void _drain(uint8_t limit);
+    ProtractorFrameEncoder _encoder;
+    Print* _port;
+    uint8_t _buffer[TELEMETRYBUFFER]; // Ring buffer of bytes to send
+    uint8_t _head; // Next byte to send
+    uint8_t _count; // Bytes queued
+    uint32_t _dropped;
+};
+
+#endif
@@ -0,0 +1,217 @@
+/*
+  ProtractorTransport.cpp - Links between the Arduino and the Protractor Sensor
+  Copyright (c) 2017 William Moore.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "Arduino.h"
+#include "Protractor.h"
+#include "ProtractorTransport.h"
+
+/////// ANY LINK ///////
+
+// The same wait as Protractor.read(), for users of a transport that need nothing else, such as ProtractorLite
+uint8_t ProtractorTransport::readFrame(uint8_t address, uint8_t frame[], uint8_t length) {
+  if(!startRead(address,frame,length)) return 0;
+  uint8_t received = 0;
+  unsigned long progressTime = micros();
+  while(true) {
+    bool more = busy(); // Checked first, so that bytes arriving in between are picked up by the next receive
+    uint8_t now = receive(frame,received,length);
+    if(now >= length || !more) return now;
+    if(now != received) {
+      received = now;
+      progressTime = micros();
+    } else if(micros() - progressTime >= READTIMEOUT) {
+      abort();
+      return received;
+    }
+  }
+}
+
+/////// STREAM ///////
+
+ProtractorStreamTransport::ProtractorStreamTransport()
+{
+  _serial = 0;
+}
+
+void ProtractorStreamTransport::begin(Stream &serial) {
+  _serial = &serial;
+}
+
+// Send a signal (char REQUESTDATA) to tell Protractor that it needs to send data, tell it the number of bytes to send.
+bool ProtractorStreamTransport::startRead(uint8_t address, uint8_t frame[], uint8_t length) {
+  (void)address; (void)frame;
+  uint8_t sendData[3] = {REQUESTDATA,length,'\n'};
+  _serial->write(sendData,3);
+  return 1;
+}
+
+uint8_t ProtractorStreamTransport::receive(uint8_t frame[], uint8_t received, uint8_t length) {
+  while(received < length && _serial->available()) {
+    frame[received] = _serial->read();
+    received++;
+  }
+  return received;
+}
+
+// The next byte may always be on its way. Protractor gives up when none arrives for a while.
+bool ProtractorStreamTransport::busy() {
+  return 1;
+}
+
+void ProtractorStreamTransport::write(uint8_t address, const uint8_t data[], uint8_t length) {
+  (void)address;
+  _serial->write(data,length);
+}
+
+/////// WIRE ///////
+
+void ProtractorWireTransport::begin(TwoWire &wire) {
+  _wire = &wire;
+  _serial = &wire; // TwoWire is a Stream, so the received bytes are collected the same way
+  _wire->begin();
+}
+
+bool ProtractorWireTransport::startRead(uint8_t address, uint8_t frame[], uint8_t length) {
+  (void)frame;
+  _wire->requestFrom(address, length);
+  return 1;
+}
+
+// requestFrom() has finished by the time it returns, nothing more will arrive
+bool ProtractorWireTransport::busy() {
+  return 0;
+}
+
+// endTransmission(false) holds the bus, so requestFrom() starts with a repeated start
+bool ProtractorWireTransport::startWriteRead(uint8_t address, const uint8_t data[], uint8_t writeLength, uint8_t frame[], uint8_t length) {
+  (void)frame;
+  _wire->beginTransmission(address);
+  _wire->write(data,writeLength);
+  if(_wire->endTransmission(false) != 0) return 0;
+  _wire->requestFrom(address, length);
+  return 1;
+}
+
+void ProtractorWireTransport::write(uint8_t address, const uint8_t data[], uint8_t length) {
+  _wire->beginTransmission(address);
+  _wire->write(data,length);
+  _wire->endTransmission();
+}
+
+bool ProtractorWireTransport::singleCommand() {
+  return 1;
+}
+
+// TwoWire does not say whether it can reach clock, the validation reads of Protractor.negotiateClock() find out
+bool ProtractorWireTransport::setClock(uint32_t clock) {
+  _wire->setClock(clock);
+  return 1;
+}
+
+/////// RS-485 ///////
+
+void ProtractorRS485Transport::begin(Stream &serial, uint8_t directionPin) {
+  ProtractorStreamTransport::begin(serial);
+  _directionPin = directionPin;
+  pinMode(_directionPin, OUTPUT);
+  digitalWrite(_directionPin, LOW); // Listen
+}
+
+bool ProtractorRS485Transport::startRead(uint8_t address, uint8_t frame[], uint8_t length) {
+  (void)frame;
+  if(address != 0) {
+    while(_serial->available()) _serial->read(); // A late answer from the previous node must not be taken for this one's
+  }
+  uint8_t sendData[3] = {REQUESTDATA,length,'\n'};
+  _send(address,sendData,3);
+  return 1;
+}
+
+void ProtractorRS485Transport::write(uint8_t address, const uint8_t data[], uint8_t length) {
+  _send(address,data,length);
+}
+
+// Drives the line only while sending. flush() waits until the last stop bit has left the port, so the
+// transceiver is back to listening before the Protractor starts to answer.
+void ProtractorRS485Transport::_send(uint8_t address, const uint8_t data[], uint8_t length) {
+  digitalWrite(_directionPin, HIGH);
+  if(address != 0) {
+    _serial->write((uint8_t)(RS485NODE | address));
+  }
+  _serial->write(data,length);
+  _serial->flush();
+  digitalWrite(_directionPin, LOW);
+}
+
+/////// LOOPBACK ///////
+
+ProtractorLoopback::ProtractorLoopback()
+{
+  _frame = 0;
+  _frameLength = 0;
+  _copied = 0;
+  _reads = 0;
+  _commands = 0;
+  _commandLength = 0;
+}
+
+void ProtractorLoopback::setFrame(const uint8_t frame[], uint8_t length) {
+  _frame = frame;
+  _frameLength = length;
+}
+
+uint32_t ProtractorLoopback::reads() {
+  return _reads;
+}
+
+uint32_t ProtractorLoopback::commands() {
+  return _commands;
+}
+
+const uint8_t* ProtractorLoopback::command() {
+  return _command;
+}
+
+uint8_t ProtractorLoopback::commandLength() {
+  return _commandLength;
+}
+
+bool ProtractorLoopback::startRead(uint8_t address, uint8_t frame[], uint8_t length) {
+  (void)address;
+  _reads++;
+  _copied = length < _frameLength ? length : _frameLength;
+  for(uint8_t i = 0; i < _copied; i++) frame[i] = _frame[i];
+  return 1;
+}
+
+uint8_t ProtractorLoopback::receive(uint8_t frame[], uint8_t received, uint8_t length) {
+  (void)frame; (void)received; (void)length;
+  return _copied;
+}
+
+bool ProtractorLoopback::busy() {
+  return 0;
+}
+
+void ProtractorLoopback::write(uint8_t address, const uint8_t data[], uint8_t length) {
+  (void)address;
+  _commands++;
+  _commandLength = length < LOOPBACKCOMMAND ? length : LOOPBACKCOMMAND;
+  for(uint8_t i = 0; i < _commandLength; i++) _command[i] = data[i];
+}
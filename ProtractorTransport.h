@@ -0,0 +1,148 @@
+/*
+  ProtractorTransport.h - Links between the Arduino and the Protractor Sensor
+  Copyright (c) 2017 William Moore.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+  ###########################################################################
+
+  The Protractor speaks the same frame protocol over every link: a read asks for 1+4*obs bytes and the
+  frame comes back, a setting is a short command. A ProtractorTransport carries that protocol over one
+  kind of link, so Protractor itself does not need to know which link is in use. Protractor.begin(Wire,
+  address) and Protractor.begin(Serial) use the Wire and Stream transports below; any other transport is
+  passed to Protractor.begin(transport, address).
+
+    ProtractorWireTransport    I2C through a TwoWire object
+    ProtractorStreamTransport  Serial through any Stream: HardwareSerial, SoftwareSerial or a USB-CDC port
+    ProtractorRS485Transport   Serial through an RS-485 transceiver, switching its direction pin. Several
+                               sensors can share the bus in multi-drop mode.
+    ProtractorLoopback         No link at all. Answers every read with a frame held in memory, for tests and
+                               benchmarks on a PC.
+    ProtractorUART             Interrupt driven Serial on AVR, see its header
+
+  A new link is added by deriving from ProtractorTransport. address is the sensor's address on links that
+  have one, such as I2C; point to point links ignore it.
+
+  On an RS-485 bus, address is the sensor's node address, 1 to 126. Each request and command to a node is
+  sent with the byte RS485NODE+address in front of it, and only that node answers. RS485BROADCAST reaches
+  every node, for commands that need no answer. Address 0 sends no prefix, for a single sensor on the bus.
+
+  I2C links can also write a few bytes and read the answer in a single transaction with startWriteRead().
+  The read follows the write with a repeated start instead of a stop and a new start, so another master
+  on a shared bus cannot take the bus in between, and the stop, the bus free time and a start are saved.
+
+  ############################################################################
+*/
+
+#ifndef ProtractorTransport_h
+#define ProtractorTransport_h
+
+#include <Wire.h>
+#include <inttypes.h>
+
+// Results of a transaction on the interrupt driven transports
+#define TRANSFER_OK    0 // Every byte was sent or received
+#define TRANSFER_BUSY  1 // The transaction has not finished yet
+#define TRANSFER_NACK  2 // The device did not acknowledge its address or a data byte
+#define TRANSFER_ERROR 3 // Arbitration was lost, the bus or line misbehaved, or the hardware is missing
+
+#define RS485NODE      0x80 // Added to the node address in the byte sent in front of an addressed request or command
+#define RS485BROADCAST 127  // Node address that every sensor on an RS-485 bus listens to
+
+#define LOOPBACKCOMMAND 8 // Longest command kept by ProtractorLoopback
+#define READTIMEOUT 20000 // micro-seconds a read waits for its next byte before giving up
+
+class ProtractorTransport
+{
+  public:
+    virtual bool startRead(uint8_t address, uint8_t frame[], uint8_t length) = 0; // Asks the sensor on address for length frame bytes, to be stored in frame. Returns false if the request could not be made.
+    virtual uint8_t receive(uint8_t frame[], uint8_t received, uint8_t length) = 0; // Stores bytes that have arrived in frame, after the received bytes already there. Returns the number of bytes received so far, at most length.
+    virtual bool busy() = 0; // returns true while more bytes of the running read may still arrive
+    virtual bool startWriteRead(uint8_t address, const uint8_t data[], uint8_t writeLength, uint8_t frame[], uint8_t length) { (void)address; (void)data; (void)writeLength; (void)frame; (void)length; return 0; } // I2C only. Writes data, then reads length bytes into frame after a repeated start, collected with receive() like startRead(). Returns false if the link has no repeated start or the transaction could not be made.
+    virtual void abort() {} // Gives up on the running read
+    virtual void write(uint8_t address, const uint8_t data[], uint8_t length) = 0; // Sends a command to the sensor on address. data may be changed as soon as write returns.
+    virtual bool singleCommand() { return 0; } // returns true if the sensor takes only one command per write, as over I2C
+    virtual bool setClock(uint32_t clock) { (void)clock; return 0; } // Sets the I2C clock to clock Hz. Returns false if the link has no clock, or cannot run at that rate.
+    uint8_t readFrame(uint8_t address, uint8_t frame[], uint8_t length); // Reads length bytes into frame and waits for them. Gives up if no byte arrives for READTIMEOUT micro-seconds. Returns the number of bytes received.
+};
+
+// Serial through any Stream
+class ProtractorStreamTransport : public ProtractorTransport
+{
+  public:
+    ProtractorStreamTransport();
+    void begin(Stream &serial); // Use serial, which must already be started at the Protractor's baud rate
+    virtual bool startRead(uint8_t address, uint8_t frame[], uint8_t length);
+    virtual uint8_t receive(uint8_t frame[], uint8_t received, uint8_t length);
+    virtual bool busy();
+    virtual void write(uint8_t address, const uint8_t data[], uint8_t length);
+  protected:
+    Stream* _serial; // Handle for the Serial object. May be a HW or SW serial.
+};
+
+// I2C through a TwoWire object. Wire reads the whole frame before startRead() returns.
+class ProtractorWireTransport : public ProtractorStreamTransport
+{
+  public:
+    void begin(TwoWire &wire); // Use wire, and start it as bus master
+    virtual bool startRead(uint8_t address, uint8_t frame[], uint8_t length);
+    virtual bool busy();
+    virtual bool startWriteRead(uint8_t address, const uint8_t data[], uint8_t writeLength, uint8_t frame[], uint8_t length);
+    virtual void write(uint8_t address, const uint8_t data[], uint8_t length);
+    virtual bool singleCommand();
+    virtual bool setClock(uint32_t clock);
+  private:
+    TwoWire* _wire; // Handle for the TwoWire object (i2c). Allows usage of boards with multiple Wire ports.
+};
+
+// Serial through a half-duplex RS-485 transceiver. The direction pin drives the transceiver's DE and /RE pins:
+// HIGH while sending, LOW while listening. Give each Protractor on a multi-drop bus its node address in
+// Protractor.begin(transport,address), and use one ProtractorPoller to read them in turn.
+class ProtractorRS485Transport : public ProtractorStreamTransport
+{
+  public:
+    void begin(Stream &serial, uint8_t directionPin); // Use serial through the transceiver switched by directionPin
+    virtual bool startRead(uint8_t address, uint8_t frame[], uint8_t length);
+    virtual void write(uint8_t address, const uint8_t data[], uint8_t length);
+  protected:
+    void _send(uint8_t address, const uint8_t data[], uint8_t length); // Sends data, addressed to a node if address is not 0, and turns the line around once the last bit is out
+    uint8_t _directionPin;
+};
+
+// Answers every read with a frame held in memory. Commands are counted and the most recent one is kept.
+class ProtractorLoopback : public ProtractorTransport
+{
+  public:
+    ProtractorLoopback();
+    void setFrame(const uint8_t frame[], uint8_t length); // Frame returned by the following reads. It is not copied, so it must stay in memory. length 0 makes reads fail, as if the sensor did not answer.
+    uint32_t reads(); // returns the number of reads requested so far
+    uint32_t commands(); // returns the number of commands written so far
+    const uint8_t* command(); // returns the most recent command, up to LOOPBACKCOMMAND bytes
+    uint8_t commandLength(); // returns the length of the most recent command
+    virtual bool startRead(uint8_t address, uint8_t frame[], uint8_t length);
+    virtual uint8_t receive(uint8_t frame[], uint8_t received, uint8_t length);
+    virtual bool busy();
+    virtual void write(uint8_t address, const uint8_t data[], uint8_t length);
+  private:
+    const uint8_t* _frame;
+    uint8_t _frameLength;
+    uint8_t _copied; // Bytes handed to the running read
+    uint32_t _reads;
+    uint32_t _commands;
+    uint8_t _command[LOOPBACKCOMMAND];
+    uint8_t _commandLength;
+};
+
+#endif
@@ -0,0 +1,167 @@
+/*
+  ProtractorUART.cpp - Interrupt driven Serial frame receiver for the Protractor Sensor on AVR
+  Copyright (c) 2017 William Moore.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "Arduino.h"
+#include "Protractor.h"
+#include "ProtractorUART.h"
+#if defined(__AVR__) && defined(UDR0)
+#define HAVEUART
+#endif
+
+ProtractorUART* ProtractorUART::_active = 0;
+
+ProtractorUART::ProtractorUART()
+{
+  _txLength = 0;
+  _txIndex = 0;
+  _data = 0;
+  _length = 0;
+  _index = 0;
+  _status = TRANSFER_OK;
+  _dropped = 0;
+}
+
+// Takes over USART0 at baudRate, 8N1
+void ProtractorUART::begin(uint32_t baudRate) {
+#if defined(HAVEUART)
+  _active = this;
+  UCSR0B = 0;
+  UCSR0A = _BV(U2X0); // Double speed, the same baud rate error as HardwareSerial
+  UBRR0 = (uint16_t)((F_CPU / 4 / baudRate - 1) / 2);
+  UCSR0C = _BV(UCSZ01) | _BV(UCSZ00);
+  UCSR0B = _BV(RXEN0) | _BV(TXEN0) | _BV(RXCIE0);
+  _status = TRANSFER_OK;
+#else
+  (void)baudRate;
+#endif
+}
+
+// Queues a command for the transmit interrupt
+void ProtractorUART::write(uint8_t address, const uint8_t data[], uint8_t length) {
+  (void)address;
+  _queue(data,length);
+}
+
+// Copies bytes to the transmit buffer, where txIsr() picks them up
+bool ProtractorUART::_queue(const uint8_t data[], uint8_t length) {
+  if(length > UARTTXBUFFER) return 0;
+#if defined(HAVEUART)
+  while(UCSR0B & _BV(UDRIE0)); // Previous write still going out
+  for(uint8_t i = 0; i < length; i++) _tx[i] = data[i];
+  _txIndex = 0;
+  _txLength = length;
+  if(length > 0) UCSR0B |= _BV(UDRIE0); // txIsr() sends the bytes
+  return 1;
+#else
+  (void)data;
+  return 0;
+#endif
+}
+
+// Stores the next length bytes received in buffer, then asks the Protractor for them
+bool ProtractorUART::startRead(uint8_t address, uint8_t buffer[], uint8_t length) {
+  (void)address;
+#if defined(HAVEUART)
+  if(_status == TRANSFER_BUSY || length == 0) return 0;
+  uint8_t sreg = SREG;
+  cli();
+  _data = buffer;
+  _length = length;
+  _index = 0;
+  _status = TRANSFER_BUSY;
+  SREG = sreg;
+  uint8_t sendData[3] = {REQUESTDATA,length,'\n'}; // Listening already, the answer may come quickly
+  _queue(sendData,3);
+  return 1;
+#else
+  (void)buffer; (void)length;
+  _status = TRANSFER_ERROR;
+  return 0;
+#endif
+}
+
+// returns true once the most recent read has finished
+bool ProtractorUART::complete() {
+  return _status != TRANSFER_BUSY;
+}
+
+uint8_t ProtractorUART::status() {
+  return _status;
+}
+
+uint8_t ProtractorUART::transferred() {
+  return _index;
+}
+
+uint16_t ProtractorUART::dropped() {
+#if defined(HAVEUART)
+  uint8_t sreg = SREG;
+  cli();
+  uint16_t dropped = _dropped;
+  SREG = sreg;
+  return dropped;
+#else
+  return _dropped;
+#endif
+}
+
+uint8_t ProtractorUART::receive(uint8_t frame[], uint8_t received, uint8_t length) {
+  (void)frame; (void)received; (void)length;
+  return _index;
+}
+
+bool ProtractorUART::busy() {
+  return _status == TRANSFER_BUSY;
+}
+
+// Stops the running read
+void ProtractorUART::abort() {
+  _status = TRANSFER_ERROR;
+}
+
+/////// INTERRUPTS ///////
+
+// Stores a received byte straight into the buffer of the running read
+void ProtractorUART::rxIsr() {
+#if defined(HAVEUART)
+  ProtractorUART* uart = _active;
+  bool damaged = UCSR0A & (_BV(FE0) | _BV(DOR0)); // Must be read before UDR0
+  uint8_t data = UDR0;
+  if(uart->_status != TRANSFER_BUSY) {
+    uart->_dropped++;
+    return;
+  }
+  if(damaged) { // The rest of this frame can't be trusted
+    uart->_dropped++;
+    uart->_status = TRANSFER_ERROR;
+    return;
+  }
+  uart->_data[uart->_index++] = data;
+  if(uart->_index >= uart->_length) uart->_status = TRANSFER_OK;
+#endif
+}
+
+// Sends the next queued byte, and stops the interrupt after the last one
+void ProtractorUART::txIsr() {
+#if defined(HAVEUART)
+  ProtractorUART* uart = _active;
+  UDR0 = uart->_tx[uart->_txIndex++];
+  if(uart->_txIndex >= uart->_txLength) UCSR0B &= ~_BV(UDRIE0);
+#endif
+}
@@ -0,0 +1,92 @@
+/*
+  ProtractorUART.h - Interrupt driven Serial frame receiver for the Protractor Sensor on AVR
+  Copyright (c) 2017 William Moore.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+  ###########################################################################
+
+  Over Serial, a frame takes 1.8 milli-seconds at 115200 baud and 18 milli-seconds at 9600 baud, and
+  Protractor.read() spends all of that time polling the port. ProtractorUART drives the AVR's USART0
+  directly. Once a read is started, the receive interrupt stores each byte straight into the Protractor's
+  frame buffer and marks the frame complete when the last byte arrives, and the request itself is sent by
+  the transmit interrupt. The sketch finds out with Protractor.readComplete(), or by passing a callback to
+  Protractor.onReadComplete() that Protractor.update() calls from the loop.
+
+  HardwareSerial owns the same interrupts, so Serial (USART0) cannot be used in the same sketch. Place
+  PROTRACTOR_UART_ISR() once in the sketch, outside of any function, to bind them to this driver. On
+  boards without USART0 begin() does nothing and every transaction fails with TRANSFER_ERROR.
+
+  ############################################################################
+*/
+
+#ifndef ProtractorUART_h
+#define ProtractorUART_h
+
+#include <inttypes.h>
+#include "ProtractorTransport.h"
+
+#define UARTTXBUFFER 8 // Largest command that can be queued for sending, in bytes
+
+class ProtractorUART : public ProtractorTransport
+{
+  public:
+    ProtractorUART();
+    void begin(uint32_t baudRate = 9600); // Takes over USART0 at baudRate, 8 data bits, no parity, 1 stop bit
+    virtual void write(uint8_t address, const uint8_t data[], uint8_t length); // Queues a command of up to UARTTXBUFFER bytes for the transmit interrupt. Waits only if a previous command is still being sent. address is ignored.
+    virtual bool startRead(uint8_t address, uint8_t buffer[], uint8_t length); // Stores the next length bytes received in buffer, and sends the request for them. address is ignored. Returns false if a read is still running.
+    bool complete(); // returns true once the most recent read has finished, successfully or not
+    uint8_t status(); // returns TRANSFER_OK, TRANSFER_BUSY or TRANSFER_ERROR for the most recent read
+    uint8_t transferred(); // returns the number of bytes received so far by the most recent read
+    uint16_t dropped(); // returns the number of bytes received while no read was running, or damaged on the line
+    virtual void abort(); // Stops the running read. status() becomes TRANSFER_ERROR.
+    virtual uint8_t receive(uint8_t frame[], uint8_t received, uint8_t length); // returns transferred(), the interrupt has already stored the bytes
+    virtual bool busy(); // returns true while a read is running
+    static void rxIsr(); // Stores a received byte. Called from the USART receive interrupt only.
+    static void txIsr(); // Sends the next queued byte. Called from the USART data register empty interrupt only.
+  private:
+    bool _queue(const uint8_t data[], uint8_t length);
+    static ProtractorUART* _active; // Driver that owns USART0
+    uint8_t _tx[UARTTXBUFFER]; // Bytes queued for sending
+    volatile uint8_t _txLength; // Number of bytes in _tx
+    volatile uint8_t _txIndex; // Next byte of _tx to send
+    uint8_t* volatile _data; // Buffer being filled by the running read
+    volatile uint8_t _length; // Number of bytes the read expects
+    volatile uint8_t _index; // Number of bytes received so far
+    volatile uint8_t _status; // TRANSFER_ result of the most recent read
+    volatile uint16_t _dropped; // Bytes nobody was waiting for
+};
+
+#if defined(__AVR__)
+#include <avr/io.h>
+#endif
+#if defined(__AVR__) && defined(UDR0)
+#include <avr/interrupt.h>
+#if defined(USART0_RX_vect)
+#define PROTRACTOR_UART_RX_vect   USART0_RX_vect
+#define PROTRACTOR_UART_UDRE_vect USART0_UDRE_vect
+#else
+#define PROTRACTOR_UART_RX_vect   USART_RX_vect
+#define PROTRACTOR_UART_UDRE_vect USART_UDRE_vect
+#endif
+// Binds the USART0 interrupts to ProtractorUART. Place once in the sketch, outside of any function.
+#define PROTRACTOR_UART_ISR() \
+  ISR(PROTRACTOR_UART_RX_vect) { ProtractorUART::rxIsr(); } \
+  ISR(PROTRACTOR_UART_UDRE_vect) { ProtractorUART::txIsr(); }
+#else
+#define PROTRACTOR_UART_ISR()
+#endif
+
+#endif
@@ -21,6 +21,8 @@ The Protractor library can be downloaded at (https://github.com/robogao/Protract
 #include <Wire.h>
 #include <LSM303.h>
 #include <Protractor.h>
+#include <ProtractorFilter.h>
+#include <ProtractorI2CBus.h>
 
 // #define LOG_SERIAL // write log output to serial port
 
@@ -28,7 +30,7 @@ The Protractor library can be downloaded at (https://github.com/robogao/Protract
 Pushbutton button(ZUMO_BUTTON); // pushbutton on pin 12
 
 // Accelerometer Settings
-#define RA_SIZE 3  // number of readings to include in running average of accelerometer readings
+#define RA_SIZE 3  // number of readings to include in running average of accelerometer readings. A power of two, such as 4, averages with a shift instead of a division.
 #define XY_ACCELERATION_THRESHOLD 2400  // for detection of contact (~16000 = magnitude of acceleration due to gravity)
 
 // Reflectance Sensor Settings
@@ -66,6 +68,13 @@ const char sound_effect[] PROGMEM = "O4 T100 V15 L4 MS g12>c12>e12>G6>E12 ML>G2"
 
 // Protractor Sensor
 Protractor protractor;
+
+// The Protractor and the LSM303 share the I2C bus. The bus reads the accelerometer in the background at low
+// priority, and only when it will be done before the next Protractor frame.
+ProtractorI2CBus i2c;
+ProtractorI2CJob accelerometerJob;
+#define ACCELEROMETER_PERIOD   10  // ms between accelerometer reads
+#define ACCELEROMETER_BUS_TIME 500 // us the LSM303 library holds the bus for one read
  
  // Timing
 unsigned long loop_start_time;
@@ -74,29 +83,6 @@ unsigned long contact_made_time;
 #define MIN_DELAY_AFTER_TURN          400  // ms = min delay before detecting contact event
 #define MIN_DELAY_BETWEEN_CONTACTS   1000  // ms = min delay between detecting new contact event
 
-// RunningAverage class 
-// based on RunningAverage library for Arduino
-// source:  http://playground.arduino.cc/Main/RunningAverage
-template <typename T> 
-class RunningAverage
-{
-  public:
-    RunningAverage(void);
-    RunningAverage(int);
-    ~RunningAverage();
-    void clear();
-    void addValue(T);
-    T getAverage() const;
-    void fillValue(T, int);
-  protected:
-    int _size;
-    int _cnt;
-    int _idx;
-    T _sum;
-    T * _ar;
-    static T zero;
-};
-
 // Accelerometer Class -- extends the LSM303 Library to support reading and averaging the x-y acceleration 
 //   vectors from the onboard LSM303DLHC accelerometer/magnetometer
 class Accelerometer : public LSM303
@@ -110,7 +96,7 @@ class Accelerometer : public LSM303
   } acc_data_xy;
   
   public: 
-    Accelerometer() : ra_x(RA_SIZE), ra_y(RA_SIZE) {};
+    Accelerometer() {};
     ~Accelerometer() {};
     void enable(void);
     void getLogHeader(void);
@@ -123,8 +109,8 @@ class Accelerometer : public LSM303
     float dir_xy_avg(void) const;
   private:
     acc_data_xy last;
-    RunningAverage<int> ra_x;
-    RunningAverage<int> ra_y;   
+    ProtractorRunningSum<RA_SIZE> ra_x;
+    ProtractorRunningSum<RA_SIZE> ra_y;
 };
 
 Accelerometer lsm303;
@@ -133,18 +119,32 @@ boolean in_contact;  // set when accelerometer detects contact with opposing rob
 // forward declaration
 void setForwardSpeed(ForwardSpeed speed);
 
+// Run by the I2C bus when the accelerometer is due
+void readAccelerometer(ProtractorI2CJob &)
+{
+  lsm303.readAcceleration(millis());
+}
+
 void setup()
 {  
   // Initiate the Wire library and join the I2C bus as a master
-  Wire.begin();
+  i2c.begin(Wire);
   
   // Initiate LSM303
   lsm303.init();
   lsm303.enable();
 
   // Initiate Protractor
-  protractor.begin(Wire,69);
+  protractor.begin(i2c,69);
   int protractorConnected = protractor.read(0);
+
+  // Read the accelerometer in between Protractor frames, which are read once per loop, about every 15 ms
+  accelerometerJob.run = readAccelerometer;
+  accelerometerJob.busTime = ACCELEROMETER_BUS_TIME;
+  accelerometerJob.priority = I2CPRIORITYLOW;
+  accelerometerJob.period = ACCELEROMETER_PERIOD * 1000UL;
+  i2c.framePeriod(MINDUR * 1000UL);
+  i2c.submit(accelerometerJob);
   
   
 #ifdef LOG_SERIAL
@@ -209,7 +209,7 @@ void loop()
   }
   
   loop_start_time = millis();
-  lsm303.readAcceleration(loop_start_time); 
+  i2c.update(); // reads the accelerometer if it is due
   sensors.read(sensor_values);
   protractor.read();
   
@@ -374,8 +374,8 @@ void Accelerometer::readAcceleration(unsigned long timestamp)
   last.x = a.x;
   last.y = a.y;
   
-  ra_x.addValue(last.x);
-  ra_y.addValue(last.y);
+  ra_x.add(last.x);
+  ra_y.add(last.y);
  
 #ifdef LOG_SERIAL
  Serial.print(last.timestamp);
@@ -407,12 +407,12 @@ float Accelerometer::dir_xy() const
 
 int Accelerometer::x_avg(void) const
 {
-  return ra_x.getAverage();
+  return ra_x.average();
 }
 
 int Accelerometer::y_avg(void) const
 {
-  return ra_y.getAverage();
+  return ra_y.average();
 }
 
 long Accelerometer::ss_xy_avg(void) const
@@ -426,71 +426,3 @@ float Accelerometer::dir_xy_avg(void) const
 {
   return atan2(static_cast<float>(x_avg()), static_cast<float>(y_avg())) * 180.0 / M_PI;
 }
-
-
-
-// RunningAverage class 
-// based on RunningAverage library for Arduino
-// source:  http://playground.arduino.cc/Main/RunningAverage
-// author:  Rob.Tillart@gmail.com
-// Released to the public domain
-
-template <typename T>
-T RunningAverage<T>::zero = static_cast<T>(0);
-
-template <typename T>
-RunningAverage<T>::RunningAverage(int n)
-{
-  _size = n;
-  _ar = (T*) malloc(_size * sizeof(T));
-  clear();
-}
-
-template <typename T>
-RunningAverage<T>::~RunningAverage()
-{
-  free(_ar);
-}
-
-// resets all counters
-template <typename T>
-void RunningAverage<T>::clear() 
-{ 
-  _cnt = 0;
-  _idx = 0;
-  _sum = zero;
-  for (int i = 0; i< _size; i++) _ar[i] = zero;  // needed to keep addValue simple
-}
-
-// adds a new value to the data-set
-template <typename T>
-void RunningAverage<T>::addValue(T f)
-{
-  _sum -= _ar[_idx];
-  _ar[_idx] = f;
-  _sum += _ar[_idx];
-  _idx++;
-  if (_idx == _size) _idx = 0;  // faster than %
-  if (_cnt < _size) _cnt++;
-}
-
-// returns the average of the data-set added so far
-template <typename T>
-T RunningAverage<T>::getAverage() const
-{
-  if (_cnt == 0) return zero; // NaN ?  math.h
-  return _sum / _cnt;
-}
-
-// fill the average with a value
-// the param number determines how often value is added (weight)
-// number should preferably be between 1 and size
-template <typename T>
-void RunningAverage<T>::fillValue(T value, int number)
-{
-  clear();
-  for (int i = 0; i < number; i++) 
-  {
-    addValue(value);
-  }
-}
@@ -21,6 +21,7 @@ The Protractor library can be downloaded at (https://github.com/robogao/Protract
 #include <Wire.h>
 #include <LSM303.h>
 #include <Protractor.h>
+#include <ProtractorFilter.h>
 
 // #define LOG_SERIAL // write log output to serial port
 
@@ -28,7 +29,7 @@ The Protractor library can be downloaded at (https://github.com/robogao/Protract
 Pushbutton button(ZUMO_BUTTON); // pushbutton on pin 12
 
 // Accelerometer Settings
-#define RA_SIZE 3  // number of readings to include in running average of accelerometer readings
+#define RA_SIZE 3  // number of readings to include in running average of accelerometer readings. A power of two, such as 4, averages with a shift instead of a division.
 #define XY_ACCELERATION_THRESHOLD 2400  // for detection of contact (~16000 = magnitude of acceleration due to gravity)
 
 // Reflectance Sensor Settings
@@ -74,29 +75,6 @@ unsigned long contact_made_time;
 #define MIN_DELAY_AFTER_TURN          400  // ms = min delay before detecting contact event
 #define MIN_DELAY_BETWEEN_CONTACTS   1000  // ms = min delay between detecting new contact event
 
-// RunningAverage class 
-// based on RunningAverage library for Arduino
-// source:  http://playground.arduino.cc/Main/RunningAverage
-template <typename T> 
-class RunningAverage
-{
-  public:
-    RunningAverage(void);
-    RunningAverage(int);
-    ~RunningAverage();
-    void clear();
-    void addValue(T);
-    T getAverage() const;
-    void fillValue(T, int);
-  protected:
-    int _size;
-    int _cnt;
-    int _idx;
-    T _sum;
-    T * _ar;
-    static T zero;
-};
-
 // Accelerometer Class -- extends the LSM303 Library to support reading and averaging the x-y acceleration 
 //   vectors from the onboard LSM303DLHC accelerometer/magnetometer
 class Accelerometer : public LSM303
@@ -110,7 +88,7 @@ class Accelerometer : public LSM303
   } acc_data_xy;
   
   public: 
-    Accelerometer() : ra_x(RA_SIZE), ra_y(RA_SIZE) {};
+    Accelerometer() {};
     ~Accelerometer() {};
     void enable(void);
     void getLogHeader(void);
@@ -123,8 +101,8 @@ class Accelerometer : public LSM303
     float dir_xy_avg(void) const;
   private:
     acc_data_xy last;
-    RunningAverage<int> ra_x;
-    RunningAverage<int> ra_y;   
+    ProtractorRunningSum<RA_SIZE> ra_x;
+    ProtractorRunningSum<RA_SIZE> ra_y;
 };
 
 Accelerometer lsm303;
@@ -350,8 +328,8 @@ void Accelerometer::readAcceleration(unsigned long timestamp)
   last.x = a.x;
   last.y = a.y;
   
-  ra_x.addValue(last.x);
-  ra_y.addValue(last.y);
+  ra_x.add(last.x);
+  ra_y.add(last.y);
  
 #ifdef LOG_SERIAL
  Serial.print(last.timestamp);
@@ -383,12 +361,12 @@ float Accelerometer::dir_xy() const
 
 int Accelerometer::x_avg(void) const
 {
-  return ra_x.getAverage();
+  return ra_x.average();
 }
 
 int Accelerometer::y_avg(void) const
 {
-  return ra_y.getAverage();
+  return ra_y.average();
 }
 
 long Accelerometer::ss_xy_avg(void) const
@@ -402,71 +380,3 @@ float Accelerometer::dir_xy_avg(void) const
 {
   return atan2(static_cast<float>(x_avg()), static_cast<float>(y_avg())) * 180.0 / M_PI;
 }
-
-
-
-// RunningAverage class 
-// based on RunningAverage library for Arduino
-// source:  http://playground.arduino.cc/Main/RunningAverage
-// author:  Rob.Tillart@gmail.com
-// Released to the public domain
-
-template <typename T>
-T RunningAverage<T>::zero = static_cast<T>(0);
-
-template <typename T>
-RunningAverage<T>::RunningAverage(int n)
-{
-  _size = n;
-  _ar = (T*) malloc(_size * sizeof(T));
-  clear();
-}
-
-template <typename T>
-RunningAverage<T>::~RunningAverage()
-{
-  free(_ar);
-}
-
-// resets all counters
-template <typename T>
-void RunningAverage<T>::clear() 
-{ 
-  _cnt = 0;
-  _idx = 0;
-  _sum = zero;
-  for (int i = 0; i< _size; i++) _ar[i] = zero;  // needed to keep addValue simple
-}
-
-// adds a new value to the data-set
-template <typename T>
-void RunningAverage<T>::addValue(T f)
-{
-  _sum -= _ar[_idx];
-  _ar[_idx] = f;
-  _sum += _ar[_idx];
-  _idx++;
-  if (_idx == _size) _idx = 0;  // faster than %
-  if (_cnt < _size) _cnt++;
-}
-
-// returns the average of the data-set added so far
-template <typename T>
-T RunningAverage<T>::getAverage() const
-{
-  if (_cnt == 0) return zero; // NaN ?  math.h
-  return _sum / _cnt;
-}
-
-// fill the average with a value
-// the param number determines how often value is added (weight)
-// number should preferably be between 1 and size
-template <typename T>
-void RunningAverage<T>::fillValue(T value, int number)
-{
-  clear();
-  for (int i = 0; i < number; i++) 
-  {
-    addValue(value);
-  }
-}
@@ -0,0 +1,93 @@
+/* PROTRACTOR - A Proximity Sensor that Measures Angles
+This is an example for the Protractor Sensor. This example will demonstrate how to give several Protractors
+sharing one I2C bus their own unique I2C addresses in a single pass. Every Protractor ships on address 69, so
+the sensors are switched on one at a time, moved to a new address, reset and verified before the next sensor
+is switched on. A final scan of the bus lists every Protractor that answers.
+
+ELECTRICAL CONNECTIONS
+
+Wire every Protractor to the I2C bus as shown below. In addition, the Vin of each Protractor is switched by
+its own transistor (or a relay) controlled by an Arduino pin listed in powerPins[] below.
+_________________________________________________________________
+  PROTRACTOR    |   UNO     |  LEONARDO |   MEGA    |   DUE     |
+--------------POWER----------------------------------------------
+    GND         |   GND     |   GND     |   GND     |   GND     |  Connect Power Supply GND to Arduino GND and Protractor GND.
+    Vin         |   Vin     |   Vin     |   Vin     |   Vin     |  NOTE: Vin must be between 6V to 14V. Switched by powerPins[].
+---------------I2C-----------------------------------------------
+    DG/DGND     |   GND     |   GND     |   GND     |   GND     |
+    VCC         |   5V      |   5V      |   5V      |   3.3V    |  Protractor VCC can be 3.3V to 5V. Used for communication only.
+    SDA         |   SDA/A4  |   SDA/2   |   SDA/20  |   SDA/20  |  Protractor has built-in level shifters
+    SCL         |   SCL/A5  |   SCL/3   |   SCL/21  |   SCL/21  |  Protractor has built-in level shifters
+-----------------------------------------------------------------
+
+For a complete tutorial on wiring up and using the Protractor go to:
+    http://www.will-moore.com/protractor/ProtractorAngleProximitySensor_UserGuide.pdf
+*/
+
+#include <Protractor.h>
+#include <ProtractorProvisioner.h>
+#include <Wire.h>
+
+#define NUMSENSORS 3
+
+ProtractorProvisioner provisioner;
+
+uint8_t powerPins[NUMSENSORS] = {4, 5, 6}; // Pin switching the Vin of each Protractor
+uint8_t newAddresses[NUMSENSORS] = {70, 71, 72}; // Address each Protractor should end up on
+uint8_t results[NUMSENSORS];
+
+// Called by the provisioner to switch a single Protractor on or off
+void power(uint8_t sensor, bool on) {
+  digitalWrite(powerPins[sensor], on ? HIGH : LOW);
+}
+
+void setup() {
+  Serial.begin(9600); // For printing results to the COM port Serial Monitor
+  for(int i = 0; i < NUMSENSORS; i++) {
+    pinMode(powerPins[i], OUTPUT);
+  }
+  provisioner.begin(Wire);
+
+  Serial.println("Protractor Provisioning Demo!");
+
+  // Move each Protractor from the default address 69 to its new address
+  int numProvisioned = provisioner.provision(NUMSENSORS, newAddresses, results, power);
+  for(int i = 0; i < NUMSENSORS; i++) {
+    Serial.print("Sensor ");
+    Serial.print(i);
+    Serial.print(" -> ");
+    Serial.print(newAddresses[i]);
+    Serial.print(": ");
+    switch(results[i]) {
+      case PROVISION_OK:            Serial.println("OK"); break;
+      case PROVISION_ALREADY:       Serial.println("already on its address"); break;
+      case PROVISION_NOT_FOUND:     Serial.println("not found, check wiring and power pin"); break;
+      case PROVISION_COLLISION:     Serial.println("more than one Protractor answered on address 69"); break;
+      case PROVISION_ADDRESS_TAKEN: Serial.println("another device already uses this address"); break;
+      case PROVISION_BAD_ADDRESS:   Serial.println("address must be between 2 and 127"); break;
+      default:                      Serial.println("did not answer on its new address"); break;
+    }
+  }
+  Serial.print(numProvisioned);
+  Serial.println(" Protractors provisioned");
+  Serial.println();
+}
+
+void loop() {
+  // List every Protractor answering on the bus
+  uint8_t found[NUMSENSORS + 1];
+  int numFound = provisioner.scan(found, NUMSENSORS + 1);
+  Serial.print("Protractors found at:");
+  for(int i = 0; i < numFound; i++) {
+    Serial.print(" ");
+    Serial.print(found[i]);
+  }
+  Serial.println();
+  if(provisioner.collisions() > 0) {
+    Serial.print("Warning, addresses shared by more than one sensor: ");
+    Serial.println(provisioner.collisions());
+  }
+
+  Serial.println();
+  delay(5000);
+}
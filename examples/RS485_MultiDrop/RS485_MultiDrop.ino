@@ -0,0 +1,79 @@
+/* PROTRACTOR - A Proximity Sensor that Measures Angles
+This is an example for the Protractor Sensor. This example will demonstrate how to read several Protractors
+that share one RS-485 bus. Each sensor has its own node address, and a ProtractorPoller asks them for a frame
+in turn. The request to the next sensor goes out as soon as a frame is complete, so the sketch handles one
+frame while the next is on its way. Every 2 seconds the number of frames, timeouts and the average time taken
+to read each sensor are printed to the Serial Monitor.
+
+The sensors must answer to the node addresses given to them, see ProtractorTransport.h.
+
+ELECTRICAL CONNECTIONS
+
+The bus uses one RS-485 transceiver, such as a MAX485, on the Arduino Mega's Serial1:
+_________________________________
+  MAX485        |   MEGA    |
+---------------------------------
+    RO          |   19      |  Serial1 RX
+    DI          |   18      |  Serial1 TX
+    DE and /RE  |   2       |  Direction pin, HIGH while sending
+    VCC, GND    |   5V, GND |
+---------------------------------
+The transceiver's A and B lines run to every Protractor on the bus. Terminate both ends of the bus with 120 Ohm.
+Connect Power Supply GND to Arduino GND and Protractor GND. NOTE: Protractor Vin must be between 6V to 14V.
+
+For a complete tutorial on wiring up and using the Protractor go to:
+    http://www.will-moore.com/protractor/ProtractorAngleProximitySensor_UserGuide.pdf
+*/
+
+#include <Protractor.h>
+#include <ProtractorPoller.h>
+
+#define NODES 4 // Sensors on the bus, at node addresses 1 to NODES
+#define DIRECTIONPIN 2
+
+ProtractorRS485Transport rs485;
+Protractor sensors[NODES];
+ProtractorPoller poller;
+unsigned long lastReport = 0;
+
+// Called by poller.update() with each frame. The next sensor is already being read.
+void frameArrived(uint8_t sensor, Protractor &protractor) {
+  int angle = protractor.objectAngle(); // -1 if no object was seen, or if the sensor did not answer
+  if(angle >= 0) {
+    // Strategy code goes here, for example steering away from the object seen by this sensor
+  }
+}
+
+void setup() {
+  Serial.begin(9600); // Serial Monitor
+  Serial1.begin(9600); // The Protractors' baud rate
+  rs485.begin(Serial1, DIRECTIONPIN);
+  for(int i = 0; i < NODES; i++) {
+    sensors[i].begin(rs485, i+1); // Node address
+    poller.add(sensors[i]);
+  }
+  poller.onFrame(frameArrived);
+  delay(500);
+}
+
+void loop() {
+  poller.update(); // Calls frameArrived() each time a frame is complete
+
+  if(millis() - lastReport >= 2000) {
+    lastReport = millis();
+    for(int i = 0; i < NODES; i++) {
+      Serial.print("Node ");
+      Serial.print(i+1);
+      Serial.print(": ");
+      Serial.print(poller.frames(i));
+      Serial.print(" frames, ");
+      Serial.print(poller.timeouts(i));
+      Serial.print(" timeouts, ");
+      Serial.print(poller.averageLatency(i));
+      Serial.println(" us per read");
+    }
+    Serial.print("Round: ");
+    Serial.print(poller.roundTime());
+    Serial.println(" us");
+  }
+}
@@ -0,0 +1,71 @@
+/* PROTRACTOR - A Proximity Sensor that Measures Angles
+This is an example for the Protractor Sensor. This example will demonstrate how to record every frame read
+from the Protractor to an SD card. Each frame is stored exactly as it was received, with a sequence number and
+a micro-second timestamp, in the binary frame log format described in ProtractorLog.h. The log can be copied
+to a PC afterwards and examined or replayed to find out what the robot saw during a match.
+
+ELECTRICAL CONNECTIONS
+
+Connect the Protractor over I2C as shown below, and an SD card module (or shield) to the SPI pins with its
+chip select on pin SDCHIPSELECT.
+_________________________________________________________________
+  PROTRACTOR    |   UNO     |  LEONARDO |   MEGA    |   DUE     |
+--------------POWER----------------------------------------------
+    GND         |   GND     |   GND     |   GND     |   GND     |  Connect Power Supply GND to Arduino GND and Protractor GND.
+    Vin         |   Vin     |   Vin     |   Vin     |   Vin     |  NOTE: Vin must be between 6V to 14V.
+---------------I2C-----------------------------------------------
+    DG/DGND     |   GND     |   GND     |   GND     |   GND     |
+    VCC         |   5V      |   5V      |   5V      |   3.3V    |  Protractor VCC can be 3.3V to 5V. Used for communication only.
+    SDA         |   SDA/A4  |   SDA/2   |   SDA/20  |   SDA/20  |  Protractor has built-in level shifters
+    SCL         |   SCL/A5  |   SCL/3   |   SCL/21  |   SCL/21  |  Protractor has built-in level shifters
+-----------------------------------------------------------------
+
+For a complete tutorial on wiring up and using the Protractor go to:
+    http://www.will-moore.com/protractor/ProtractorAngleProximitySensor_UserGuide.pdf
+*/
+
+#include <Protractor.h>
+#include <ProtractorRecorder.h>
+#include <Wire.h>
+#include <SPI.h>
+#include <SD.h>
+
+#define SDCHIPSELECT 10 // Chip select pin of the SD card
+#define FLUSHEVERY  100 // Write the log out to the card every this many frames
+
+Protractor myProtractor;
+ProtractorRecorder recorder;
+File logFile;
+
+void setup() {
+  Serial.begin(9600); // For printing results to the COM port Serial Monitor
+  myProtractor.begin(Wire,69); // Use I2C/Wire Library to talk with Protractor on default address 69
+
+  Serial.println("Protractor Recorder Demo!");
+
+  if(!SD.begin(SDCHIPSELECT)) {
+    Serial.println("SD card not found");
+    while(1);
+  }
+  logFile = SD.open("PROTRACT.LOG", FILE_WRITE);
+  if(!logFile || !recorder.begin(logFile)) {
+    Serial.println("Could not start the log file");
+    while(1);
+  }
+  Serial.println("Recording");
+}
+
+void loop() {
+  myProtractor.read(); // Communicate with the sensor to get the data
+  recorder.record(myProtractor); // Append the frame to the log, right after it was read
+
+  if(recorder.count() % FLUSHEVERY == 0) {
+    recorder.flush(); // Make sure the frames so far are on the card in case power is lost
+    Serial.print(recorder.count());
+    Serial.print(" frames recorded, ");
+    Serial.print(recorder.dropped());
+    Serial.println(" dropped");
+  }
+
+  // ... the robot's own use of the sensor data goes here ...
+}
@@ -0,0 +1,57 @@
+/* PROTRACTOR - A Proximity Sensor that Measures Angles
+This is an example for the Protractor Sensor. This example will demonstrate how to read the Protractor over
+Serial without waiting for the frame to arrive. ProtractorUART takes over the Uno's hardware serial port: the
+request is sent and the answer is stored by interrupts, while the loop keeps running. When a frame has arrived,
+Protractor.update() calls the function given to Protractor.onReadComplete(), which starts the next read. The
+built-in LED lights up while an object is straight ahead.
+
+ProtractorUART replaces the Serial object, so Serial (and the Serial Monitor) cannot be used in this sketch.
+Unplug the Protractor from pins 0 and 1 while uploading.
+
+ELECTRICAL CONNECTIONS
+
+To use the Protractor with an Arduino Uno using RX/TX, make the following connections:
+_________________________________
+  PROTRACTOR    |   UNO     |
+--------------POWER--------------
+    GND         |   GND     |  Connect Power Supply GND to Arduino GND and Protractor GND.
+    Vin         |   Vin     |  NOTE: Vin must be between 6V to 14V.
+--------------SERIAL-------------
+    DG/DGND     |   GND     |
+    VCC         |   5V      |  Protractor VCC can be 3.3V to 5V. Used for communication only.
+    TX          |   0       |
+    RX          |   1       |
+---------------------------------
+For a complete tutorial on wiring up and using the Protractor go to:
+    http://www.will-moore.com/protractor/ProtractorAngleProximitySensor_UserGuide.pdf
+*/
+
+#include <Protractor.h>
+
+Protractor myProtractor;
+ProtractorUART uart;
+PROTRACTOR_UART_ISR() // Hand the serial port's interrupts to ProtractorUART
+
+// Called by myProtractor.update() each time a frame has arrived
+void frameArrived(Protractor &protractor) {
+  int angle = protractor.objectAngle(); // -1 if no object was seen, or if the sensor did not answer
+  bool ahead = angle >= 60 && angle <= 120;
+  digitalWrite(LED_BUILTIN, ahead ? HIGH : LOW);
+  protractor.startRead(); // Ask for the next frame right away
+}
+
+void setup() {
+  pinMode(LED_BUILTIN, OUTPUT);
+  uart.begin(9600); // The Protractor's default baud rate
+  myProtractor.begin(uart); // Use ProtractorUART to talk with Protractor
+  myProtractor.onReadComplete(frameArrived);
+  delay(500);
+  myProtractor.startRead(); // Start the first read, frameArrived() starts every read after it
+}
+
+void loop() {
+  myProtractor.update(); // Calls frameArrived() once the frame is complete
+
+  // The rest of the loop keeps running while the frame is on its way, about 18 milli-seconds at 9600 baud.
+  // Motor control, other sensors, etc. go here.
+}
@@ -0,0 +1,75 @@
+/* PROTRACTOR - A Proximity Sensor that Measures Angles
+This is an example for the Protractor Sensor. This example will demonstrate how to keep the Protractor's settings
+in the Arduino's EEPROM and re-apply them every time the robot boots. The Protractor forgets its scan time and
+LED mode when it is rebooted. A ProtractorProfile stores them, together with the sensor's I2C address and how the
+sensor is mounted on the robot. The first time this example runs it saves a profile. On every boot after that,
+the profile is loaded from EEPROM and applied to the Protractor in a single step.
+
+The EEPROM is available on AVR boards such as the Uno, Leonardo and Mega.
+
+ELECTRICAL CONNECTIONS
+
+To use the Protractor with an Arduino over I2C, make the following connections:
+_________________________________________________________________
+  PROTRACTOR    |   UNO     |  LEONARDO |   MEGA    |   DUE     |
+--------------POWER----------------------------------------------
+    GND         |   GND     |   GND     |   GND     |   GND     |  Connect Power Supply GND to Arduino GND and Protractor GND.
+    Vin         |   Vin     |   Vin     |   Vin     |   Vin     |  NOTE: Vin must be between 6V to 14V.
+---------------I2C-----------------------------------------------
+    DG/DGND     |   GND     |   GND     |   GND     |   GND     |
+    VCC         |   5V      |   5V      |   5V      |   3.3V    |  Protractor VCC can be 3.3V to 5V. Used for communication only.
+    SDA         |   SDA/A4  |   SDA/2   |   SDA/20  |   SDA/20  |  Protractor has built-in level shifters
+    SCL         |   SCL/A5  |   SCL/3   |   SCL/21  |   SCL/21  |  Protractor has built-in level shifters
+-----------------------------------------------------------------
+
+For a complete tutorial on wiring up and using the Protractor go to:
+    http://www.will-moore.com/protractor/ProtractorAngleProximitySensor_UserGuide.pdf
+*/
+
+#include <Protractor.h>
+#include <ProtractorProfile.h>
+#include <Wire.h>
+
+#define PROFILEADDRESS 0 // Where the profile is kept in EEPROM
+
+Protractor myProtractor;
+ProtractorProfile profile;
+
+void setup() {
+  Serial.begin(9600); // For printing results to the COM port Serial Monitor
+  Serial.println("Protractor Sensor Demo!");
+
+  if(profile.load(PROFILEADDRESS)) {
+    Serial.println("Profile loaded from EEPROM");
+  } else {
+    // No profile stored yet. Describe this robot's Protractor and save it for the next boot.
+    profile.scanTime = 50;      // Scan every 50 milliSeconds to save power
+    profile.ledMode = LEDOFF;   // Keep the LEDs off so they don't disturb other optical sensors
+    profile.address = 69;       // The Protractor is on the default I2C address
+    profile.mountYaw = 0;       // Mounted facing straight ahead
+    profile.save(PROFILEADDRESS);
+    Serial.println("New profile saved to EEPROM");
+  }
+
+  myProtractor.begin(Wire,profile.address); // Use I2C/Wire Library to talk with Protractor on the stored address
+  delay(500);
+
+  // Apply the stored scan time and LED mode in one step
+  if(myProtractor.applyProfile(profile)) {
+    Serial.println("Profile applied");
+  } else {
+    Serial.println("Profile holds invalid settings");
+  }
+}
+
+void loop() {
+  myProtractor.read(); // Communicate with the sensor to get the data
+
+  if(myProtractor.objectCount() > 0) {
+    Serial.print("Most visible object is ");
+    Serial.print(profile.robotAngle(myProtractor.objectAngle())); // Angle relative to the front of the robot
+    Serial.println(" degrees from straight ahead");
+  }
+
+  delay(1000);
+}
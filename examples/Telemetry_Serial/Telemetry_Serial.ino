@@ -0,0 +1,50 @@
+/* PROTRACTOR - A Proximity Sensor that Measures Angles
+This is an example for the Protractor Sensor. This example will demonstrate how to send every frame from the
+Protractor to a PC without slowing down the loop. Printing a frame as text takes tens of milli-seconds. Instead,
+ProtractorTelemetry compresses each frame into a few bytes and hands the Serial port only as many bytes as it
+can take without waiting. The loop keeps running at full speed.
+
+On the PC, build the tools in the library's extras/host folder and run:
+    protractor_telemetry -b 115200 /dev/ttyACM0
+to print the frames, or add "-o match.log" to save them in a frame log for protractor_replay.
+
+ELECTRICAL CONNECTIONS
+
+To use the Protractor with an Arduino over I2C, make the following connections:
+_________________________________________________________________
+  PROTRACTOR    |   UNO     |  LEONARDO |   MEGA    |   DUE     |
+--------------POWER----------------------------------------------
+    GND         |   GND     |   GND     |   GND     |   GND     |  Connect Power Supply GND to Arduino GND and Protractor GND.
+    Vin         |   Vin     |   Vin     |   Vin     |   Vin     |  NOTE: Vin must be between 6V to 14V.
+---------------I2C-----------------------------------------------
+    DG/DGND     |   GND     |   GND     |   GND     |   GND     |
+    VCC         |   5V      |   5V      |   5V      |   3.3V    |  Protractor VCC can be 3.3V to 5V. Used for communication only.
+    SDA         |   SDA/A4  |   SDA/2   |   SDA/20  |   SDA/20  |  Protractor has built-in level shifters
+    SCL         |   SCL/A5  |   SCL/3   |   SCL/21  |   SCL/21  |  Protractor has built-in level shifters
+-----------------------------------------------------------------
+
+For a complete tutorial on wiring up and using the Protractor go to:
+    http://www.will-moore.com/protractor/ProtractorAngleProximitySensor_UserGuide.pdf
+*/
+
+#include <Protractor.h>
+#include <ProtractorTelemetry.h>
+#include <Wire.h>
+
+Protractor myProtractor;
+ProtractorTelemetry telemetry;
+
+void setup() {
+  Serial.begin(115200); // Binary telemetry to the PC
+  myProtractor.begin(Wire,69); // Use I2C/Wire Library to talk with Protractor on default address 69
+  telemetry.begin(Serial);
+}
+
+void loop() {
+  myProtractor.read(); // Communicate with the sensor to get the data
+  telemetry.send(myProtractor); // Queue the frame, never waits for the Serial port
+
+  // ... the robot's own use of the sensor data goes here ...
+
+  telemetry.update(); // Send what the Serial port can take right now
+}
@@ -0,0 +1,224 @@
+/*
+  bench.cpp - Cycle counts of the Protractor library on an ATmega328P, run under simavr
+  Copyright (c) 2017 William Moore.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+  ###########################################################################
+
+  Built against the real Arduino AVR core and Wire library, so the numbers include everything a sketch on
+  an Uno pays: the Wire and HardwareSerial interrupts, micros() and the library itself. Cycles are counted
+  with Timer1 running at the CPU clock. Each benchmark is run BENCHRUNS times and the minimum and mean are
+  reported on the simavr console as:
+
+    BENCH <name> min <cycles> mean <cycles>
+
+  Built with BENCH_ISR defined, Serial goes through ProtractorUART instead of HardwareSerial. Serial is
+  never used in that build, so its benchmarks are left out. I2C goes through Wire in both builds.
+
+  Last, the I2C clock is negotiated up from 100kHz with Protractor.negotiateClock(1000000) and reported as
+
+    CLOCK <Hz> frame <micro-seconds per full frame>
+
+  followed by the frame reads again at that clock, set through Wire.setClock().
+
+  objectVectorXY looks up the unit vector toward an object in Q15; objectVectorXY_float works out the
+  same from objectAngle() with sin() and cos(), as a sketch would without the tables.
+
+  runningSum4, runningSum3, ema, median5 and alphaBeta time add() of objectAngleQ7() to a ProtractorFilter.h
+  filter and reading its result back. runningSum3 against runningSum4 is the cost of dividing instead of
+  shifting. stabilizer3 times a ProtractorStabilizer<3> taking in a full frame, the cost it adds per read.
+
+  write_then_read and write_read time an LED command followed by a frame read, as two transactions and
+  as one with a repeated start. protractor_sim -v prints how long each transaction held the bus.
+
+  protractor_sim attaches an emulated Protractor to the TWI (address 0x45) and to USART0, prints these
+  lines and exits when the firmware goes to sleep. Its TWI sensor garbles reads above 400kHz unless told
+  otherwise with -c, so the negotiation has a rate to fall back from.
+
+  The suite has not been built or run against avr-gcc and simavr yet, and no numbers from it have been
+  committed. Until they are, the AVR costs quoted in the library's headers and README are estimates.
+
+  ############################################################################
+*/
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "console.h"
+#include "Protractor.h"
+#include "ProtractorFilter.h"
+#include "ProtractorStabilizer.h"
+
+#define BENCHRUNS 16 // Times each benchmark is repeated
+#define ACCESSORCALLS 64 // Calls per run when timing accessors, which are too short to time one by one
+
+Protractor i2cProtractor;
+Protractor serialProtractor;
+#if defined(BENCH_ISR)
+ProtractorUART uart;
+PROTRACTOR_UART_ISR()
+#endif
+volatile int16_t sink; // Keeps results of accessor calls from being optimized away
+
+/////// CYCLE COUNTER ///////
+
+static volatile uint16_t overflows;
+static uint32_t overhead; // Cycles taken by an empty measurement
+
+ISR(TIMER1_OVF_vect) {
+  overflows++;
+}
+
+static inline void startCycles() {
+  TCCR1B = 0;
+  TCCR1A = 0;
+  TCNT1 = 0;
+  overflows = 0;
+  TIFR1 = _BV(TOV1);
+  TIMSK1 = _BV(TOIE1);
+  TCCR1B = _BV(CS10); // Count every CPU cycle
+}
+
+static inline uint32_t stopCycles() {
+  TCCR1B = 0;
+  uint32_t cycles = ((uint32_t)overflows << 16) | TCNT1;
+  if(TIFR1 & _BV(TOV1)) cycles += 65536UL; // Overflow not serviced yet
+  return cycles > overhead ? cycles - overhead : 0;
+}
+
+static void report(const char *name, uint32_t minimum, uint32_t total, uint16_t divisor) {
+  consolePrint("BENCH ");
+  consolePrint(name);
+  consolePrint(" min ");
+  consolePrint(minimum / divisor);
+  consolePrint(" mean ");
+  consolePrint(total / ((uint32_t)BENCHRUNS * divisor));
+  consolePrint("\n");
+}
+
+// Runs code BENCHRUNS times and reports the cycles it took, divided by divisor. untimed runs after each run.
+#define BENCHTHEN(name, divisor, code, untimed) do { \
+    uint32_t minimum = 0xFFFFFFFFUL; \
+    uint32_t total = 0; \
+    for(uint8_t run = 0; run < BENCHRUNS; run++) { \
+      startCycles(); \
+      code; \
+      uint32_t cycles = stopCycles(); \
+      total += cycles; \
+      if(cycles < minimum) minimum = cycles; \
+      untimed; \
+    } \
+    report(name, minimum, total, divisor); \
+  } while(0)
+
+#define BENCH(name, divisor, code) BENCHTHEN(name, divisor, code, )
+
+/////// WRITE THEN READ ///////
+
+static const uint8_t ledCommand[3] = {LEDUSAGE,SHOWOBJ,'\n'};
+static uint8_t reply[1+4*MAXOBJECTS];
+
+static void wireWriteRead(bool stop) {
+  Wire.beginTransmission(0x45);
+  Wire.write(ledCommand,sizeof(ledCommand));
+  Wire.endTransmission(stop);
+  Wire.requestFrom((uint8_t)0x45,(uint8_t)sizeof(reply));
+  for(uint8_t i = 0; Wire.available(); i++) reply[i] = Wire.read();
+}
+
+static void writeThenRead() {
+  wireWriteRead(true);
+}
+
+static void writeRead() {
+  wireWriteRead(false); // requestFrom() starts with a repeated start
+}
+
+/////// BENCHMARKS ///////
+
+void setup() {
+  overhead = 0;
+  startCycles();
+  overhead = stopCycles();
+
+  i2cProtractor.begin(Wire,0x45);
+
+  BENCH("read_i2c_4", 1, i2cProtractor.read());
+  BENCH("read_i2c_1", 1, i2cProtractor.read(1));
+  BENCH("write_then_read_i2c", 1, writeThenRead());
+  BENCH("write_read_i2c", 1, writeRead());
+#if defined(BENCH_ISR)
+  uart.begin(115200);
+  serialProtractor.begin(uart);
+
+  BENCH("read_uartisr115200_4", 1, serialProtractor.read());
+  BENCH("read_uartisr115200_1", 1, serialProtractor.read(1));
+  BENCHTHEN("startRead_uartisr115200_4", 1, serialProtractor.startRead(), while(!serialProtractor.readComplete()));
+#else
+  Serial.begin(115200);
+  serialProtractor.begin(Serial);
+
+  BENCH("read_serial115200_4", 1, serialProtractor.read());
+  BENCH("read_serial115200_1", 1, serialProtractor.read(1));
+#endif
+
+  i2cProtractor.read();
+  BENCH("objectCount", ACCESSORCALLS, for(uint8_t i = 0; i < ACCESSORCALLS; i++) sink = i2cProtractor.objectCount());
+  BENCH("pathCount", ACCESSORCALLS, for(uint8_t i = 0; i < ACCESSORCALLS; i++) sink = i2cProtractor.pathCount());
+  BENCH("objectAngle", ACCESSORCALLS, for(uint8_t i = 0; i < ACCESSORCALLS; i++) sink = i2cProtractor.objectAngle(i & 3));
+  BENCH("objectVisibility", ACCESSORCALLS, for(uint8_t i = 0; i < ACCESSORCALLS; i++) sink = i2cProtractor.objectVisibility(i & 3));
+  BENCH("pathAngle", ACCESSORCALLS, for(uint8_t i = 0; i < ACCESSORCALLS; i++) sink = i2cProtractor.pathAngle(i & 3));
+  BENCH("pathVisibility", ACCESSORCALLS, for(uint8_t i = 0; i < ACCESSORCALLS; i++) sink = i2cProtractor.pathVisibility(i & 3));
+  BENCH("objectVectorXY", ACCESSORCALLS, for(uint8_t i = 0; i < ACCESSORCALLS; i++) sink = i2cProtractor.objectVectorX(i & 3) + i2cProtractor.objectVectorY(i & 3));
+  BENCH("objectVectorXY_float", ACCESSORCALLS, for(uint8_t i = 0; i < ACCESSORCALLS; i++) {
+    float radians = i2cProtractor.objectAngle(i & 3)*(PI/180);
+    sink = (int16_t)(cos(radians)*32767) + (int16_t)(sin(radians)*32767);
+  });
+
+  ProtractorRunningSum<4> runningSum4;
+  ProtractorRunningSum<3> runningSum3;
+  ProtractorEMA<3> ema;
+  ProtractorMedian<5> median5;
+  ProtractorAlphaBeta<2,4> alphaBeta;
+  BENCH("runningSum4", ACCESSORCALLS, for(uint8_t i = 0; i < ACCESSORCALLS; i++) { runningSum4.add(i2cProtractor.objectAngleQ7(i & 3)); sink = runningSum4.average(); });
+  BENCH("runningSum3", ACCESSORCALLS, for(uint8_t i = 0; i < ACCESSORCALLS; i++) { runningSum3.add(i2cProtractor.objectAngleQ7(i & 3)); sink = runningSum3.average(); });
+  BENCH("ema", ACCESSORCALLS, for(uint8_t i = 0; i < ACCESSORCALLS; i++) { ema.add(i2cProtractor.objectAngleQ7(i & 3)); sink = ema.average(); });
+  BENCH("median5", ACCESSORCALLS, for(uint8_t i = 0; i < ACCESSORCALLS; i++) { median5.add(i2cProtractor.objectAngleQ7(i & 3)); sink = median5.median(); });
+  ProtractorStabilizer<3> stabilizer;
+  BENCH("stabilizer3", ACCESSORCALLS, for(uint8_t i = 0; i < ACCESSORCALLS; i++) { stabilizer.update(i2cProtractor.frame(),i2cProtractor.frameLength()); sink = stabilizer.objectAngle(0); });
+  BENCH("alphaBeta", ACCESSORCALLS, for(uint8_t i = 0; i < ACCESSORCALLS; i++) { alphaBeta.add(i2cProtractor.objectAngleQ7(i & 3)); sink = alphaBeta.value(); });
+
+  BENCH("scanTime_i2c", 1, i2cProtractor.scanTime(MINDUR));
+  BENCH("LEDshowObject_i2c", 1, i2cProtractor.LEDshowObject());
+
+  uint32_t frameTime;
+  uint32_t clock = i2cProtractor.negotiateClock(1000000,&frameTime);
+  consolePrint("CLOCK ");
+  consolePrint(clock);
+  consolePrint(" frame ");
+  consolePrint(frameTime);
+  consolePrint("\n");
+  BENCH("read_i2c_fast_4", 1, i2cProtractor.read());
+  BENCH("read_i2c_fast_1", 1, i2cProtractor.read(1));
+
+  consolePrint("BENCH done\n");
+#if !defined(BENCH_ISR)
+  Serial.flush();
+#endif
+  consoleExit();
+}
+
+void loop() {
+}
@@ -0,0 +1,59 @@
+/*
+  console.h - Text output of the avrbench firmwares, through the simavr console
+  Copyright (c) 2017 William Moore.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+  ###########################################################################
+
+  The firmwares leave USART0 to the emulated sensors and print through GPIOR0 instead, which simavr
+  passes to its console. Include this header from exactly one file of a firmware.
+
+  ############################################################################
+*/
+
+#ifndef console_h
+#define console_h
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <avr_mcu_section.h>
+
+AVR_MCU(F_CPU, "atmega328p");
+AVR_MCU_SIMAVR_CONSOLE(&GPIOR0);
+
+static void consolePrint(const char *text) {
+  while(*text) GPIOR0 = *text++;
+}
+
+static void consolePrint(uint32_t n) {
+  char digits[11];
+  uint8_t i = 0;
+  do {
+    digits[i++] = '0' + n % 10;
+    n /= 10;
+  } while(n > 0);
+  while(i > 0) GPIOR0 = digits[--i];
+}
+
+// Stops the simulation: simavr quits when the CPU sleeps with interrupts off
+static void consoleExit() {
+  cli();
+  sleep_enable();
+  sleep_cpu();
+}
+
+#endif
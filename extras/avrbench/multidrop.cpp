@@ -0,0 +1,149 @@
+/*
+  multidrop.cpp - Polls several Protractors on one RS-485 bus under simavr, and reports their latency
+  Copyright (c) 2017 William Moore.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+  ###########################################################################
+
+  Run with "protractor_sim -m 6 multidrop.elf". USART0 goes through an emulated RS-485 transceiver whose
+  direction is switched by pin 2, to six emulated Protractors on node addresses 1 to 6. A ProtractorPoller
+  reads them round-robin for MULTIDROPROUNDS rounds, then prints for each node:
+
+    NODE <address> frames <count> timeouts <count> latency <average us> max <us>
+    ROUND <us>
+
+  It then sets all of them to scan time 0 with one broadcast and runs MULTIDROPROUNDS synchronized rounds,
+  each starting with a broadcast trigger, and prints:
+
+    SYNC frames <count> timeouts <count> round <us>
+
+  Last it separates neighbouring nodes, as if the six sensors faced out from a ring, which splits them into
+  two time slots, and runs MULTIDROPROUNDS more rounds:
+
+    SLOTS <slots> frames <count> timeouts <count> round <us> slot <us> min <us>
+
+  protractor_sim checks the direction switching and reports replies that were lost to it, and how far
+  apart the triggers of one round arrived.
+
+  ############################################################################
+*/
+
+#include <Arduino.h>
+#include "console.h"
+#include "Protractor.h"
+#include "ProtractorPoller.h"
+
+#define MULTIDROPNODES  6
+#define MULTIDROPROUNDS 50
+#define DIRECTIONPIN    2
+#define MULTIDROPBAUD   115200
+
+ProtractorRS485Transport rs485;
+Protractor sensors[MULTIDROPNODES];
+Protractor everyone; // The broadcast address
+ProtractorPoller poller;
+ProtractorPoller syncPoller;
+ProtractorPoller slotPoller;
+uint32_t syncRounds = 0;
+
+void roundDone() {
+  syncRounds++;
+}
+
+void setup() {
+  Serial.begin(MULTIDROPBAUD);
+  rs485.begin(Serial, DIRECTIONPIN);
+  for(uint8_t i = 0; i < MULTIDROPNODES; i++) {
+    sensors[i].begin(rs485, i+1); // Node addresses 1 to MULTIDROPNODES
+    poller.add(sensors[i]);
+    syncPoller.add(sensors[i]);
+    slotPoller.add(sensors[i]);
+  }
+  for(uint8_t i = 0; i < MULTIDROPNODES; i++) {
+    slotPoller.separate(i, (i+1) % MULTIDROPNODES);
+  }
+  everyone.begin(rs485, RS485BROADCAST);
+
+  while(poller.frames(MULTIDROPNODES-1) + poller.timeouts(MULTIDROPNODES-1) < MULTIDROPROUNDS) {
+    poller.update();
+  }
+
+  for(uint8_t i = 0; i < MULTIDROPNODES; i++) {
+    consolePrint("NODE ");
+    consolePrint(i+1);
+    consolePrint(" frames ");
+    consolePrint(poller.frames(i));
+    consolePrint(" timeouts ");
+    consolePrint(poller.timeouts(i));
+    consolePrint(" latency ");
+    consolePrint(poller.averageLatency(i));
+    consolePrint(" max ");
+    consolePrint(poller.maxLatency(i));
+    consolePrint("\n");
+  }
+  consolePrint("ROUND ");
+  consolePrint(poller.roundTime());
+  consolePrint("\n");
+
+  syncPoller.synchronize(&everyone);
+  syncPoller.onRound(roundDone);
+  while(syncRounds < MULTIDROPROUNDS) {
+    syncPoller.update();
+  }
+  uint32_t frames = 0;
+  uint32_t timeouts = 0;
+  for(uint8_t i = 0; i < MULTIDROPNODES; i++) {
+    frames += syncPoller.frames(i);
+    timeouts += syncPoller.timeouts(i);
+  }
+  consolePrint("SYNC frames ");
+  consolePrint(frames);
+  consolePrint(" timeouts ");
+  consolePrint(timeouts);
+  consolePrint(" round ");
+  consolePrint(syncPoller.roundTime());
+  consolePrint("\n");
+
+  syncRounds = 0;
+  slotPoller.synchronize(&everyone);
+  slotPoller.onRound(roundDone);
+  while(syncRounds < MULTIDROPROUNDS) {
+    slotPoller.update();
+  }
+  frames = 0;
+  timeouts = 0;
+  for(uint8_t i = 0; i < MULTIDROPNODES; i++) {
+    frames += slotPoller.frames(i);
+    timeouts += slotPoller.timeouts(i);
+  }
+  consolePrint("SLOTS ");
+  consolePrint(slotPoller.slots());
+  consolePrint(" frames ");
+  consolePrint(frames);
+  consolePrint(" timeouts ");
+  consolePrint(timeouts);
+  consolePrint(" round ");
+  consolePrint(slotPoller.roundTime());
+  consolePrint(" slot ");
+  consolePrint(slotPoller.slotTime());
+  consolePrint(" min ");
+  consolePrint(slotPoller.minSlotTime());
+  consolePrint("\n");
+  consoleExit();
+}
+
+void loop() {
+}
@@ -0,0 +1,442 @@
+/*
+  protractor_sim.c - Runs the benchmark firmware under simavr with emulated Protractors
+  Copyright (c) 2017 William Moore.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+  ###########################################################################
+
+  usage: protractor_sim [-v] [-m nodes] [-d pin] [-t turnaround] [-c maxclock] firmware.elf
+
+  Loads an ATmega328P firmware into simavr and attaches one emulated Protractor to the TWI, answering
+  on address 0x45, and one to USART0. They answer data requests from the same set of frames, which
+  change every scan time (15 ms of simulated time by default) just like the real sensor's results. An
+  answer starts once the request's last byte has crossed the line at the USART's baud rate. Lines the
+  firmware writes to the simavr console are passed through to stdout.
+
+    -m nodes       USART0 is an RS-485 bus with this many sensors on node addresses 1 to nodes, each only
+                   answering requests addressed to it (see ProtractorTransport.h)
+    -d pin         Arduino pin switching the RS-485 transceiver's direction, 0 to 13 (default 2)
+    -t turnaround  micro-seconds a sensor waits after a request before answering (default 20)
+    -c maxclock    fastest I2C clock in Hz the TWI sensor keeps up with, 0 for no limit (default 400000).
+                   Above it, computed from TWBR and the TWSR prescaler, every byte read is 0xFF.
+    -v             print every command the emulated sensors receive, and the time of every TWI transaction
+
+  On an RS-485 bus the direction pin is checked: bytes sent while it is LOW never reach the bus, a
+  transmission cut short by setting it LOW too early is counted, and an answer that starts while it is
+  still HIGH is lost, because the transceiver is not listening.
+
+  A sensor set to scan time 0 scans once per request, or once per Protractor.trigger() (a request for 0
+  bytes), and the next request returns the triggered scan. The spread of triggers sent together, closer
+  than one scan time, is reported at the end. On an RS-485 bus the nodes are taken to sit in a ring, each
+  facing the nodes next to it, and a scan triggered on its own node address that starts while a
+  neighbour's is still running is counted as an overlap. Broadcast triggers overlap on purpose.
+
+  The time the TWI bus is held, from each start to its stop, is added up and reported at the end together
+  with the number of transactions and repeated starts; -v prints it for every transaction. A write that
+  ends in a repeated start is taken as a complete command, like one that ends in a stop.
+
+  ############################################################################
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sim_avr.h"
+#include "sim_elf.h"
+#include "sim_cycle_timers.h"
+#include "avr_twi.h"
+#include "avr_uart.h"
+#include "avr_ioport.h"
+
+#define SIMADDRESS    0x45
+#define SIMFRAMESIZE  17 // 1+4*MAXOBJECTS
+#define SIMMINDUR     15
+#define SIMMAXNODES   126
+#define REQUESTDATA   0x15
+#define SCANTIME      0x20
+#define I2CADDR       0x24
+#define BAUDRATE      0x26
+#define LEDUSAGE      0x30
+#define RS485NODE     0x80
+#define RS485BROADCAST 127
+
+// Frames the emulated sensors cycle through, one per scan. Most visible object and path first.
+static const uint8_t simFrames[][SIMFRAMESIZE] = {
+  { 0x23, 128,200, 40,180,  60,120, 220,90,   0,0, 0,0,       0,0, 0,0 },
+  { 0x32, 120,210, 45,170,  70,110, 230,80,   200,60, 0,0,    0,0, 0,0 },
+  { 0x44, 110,230, 30,200,  75,150, 210,120,  190,90, 128,60, 20,40, 100,30 },
+  { 0x01, 0,0, 128,250,     0,0, 0,0,         0,0, 0,0,       0,0, 0,0 },
+};
+#define SIMFRAMES (sizeof(simFrames)/sizeof(simFrames[0]))
+
+typedef struct sim_sensor_t {
+  char name[16];
+  avr_t *avr;
+  avr_irq_t *irq; // TWI: own irqs. USART: the USART's input irq.
+  uint8_t node; // Node address on an RS-485 bus, 0 on a point to point link
+  uint16_t scanTime; // milliSeconds, 0 = scan on request
+  uint32_t scans; // Scans started by requests and triggers while scanTime is 0
+  uint8_t triggered; // A triggered scan is waiting to be read
+  avr_cycle_count_t triggerCycle; // When the most recent trigger arrived
+  uint32_t triggers;
+  uint8_t command[8];
+  uint8_t commandLength;
+  uint8_t selected; // TWI address byte while the sensor is addressed, 0 otherwise
+  uint8_t frame[SIMFRAMESIZE]; // Frame being sent
+  uint8_t index; // Next byte of frame to send
+  uint32_t requests;
+  uint32_t commands;
+  uint32_t lost; // Answers that could not be heard on an RS-485 bus
+} sim_sensor_t;
+
+
+// USART0, with one sensor or an RS-485 bus of them
+typedef struct sim_bus_t {
+  avr_t *avr;
+  sim_sensor_t sensors[SIMMAXNODES];
+  uint8_t count; // Sensors on the bus
+  uint8_t multiDrop; // 1 on an RS-485 bus
+  uint8_t selected; // Node address from the most recent RS485NODE byte
+  uint8_t driving; // Direction pin level, 1 while the firmware drives the bus
+  avr_cycle_count_t txEnd; // Cycle when the last byte sent by the firmware has left the USART
+  sim_sensor_t *answering; // Sensor whose answer is scheduled, 0 if none
+  uint8_t answerLength;
+  uint32_t overlaps; // Triggered scans that started while a neighbouring node was still scanning
+  uint32_t unheard; // Bytes sent by the firmware while not driving the bus
+  uint32_t truncated; // Times the bus was released before the last byte was out
+} sim_bus_t;
+
+// Time the TWI bus is held, from a start to its stop, with every repeated start in between
+typedef struct sim_twi_bus_t {
+  avr_cycle_count_t start; // Cycle of the start that took the bus, 0 while the bus is free
+  avr_cycle_count_t busy; // Cycles the bus was held in total
+  uint32_t transactions; // Starts that took a free bus
+  uint32_t repeatedStarts;
+} sim_twi_bus_t;
+
+static int verbose = 0;
+static uint32_t twiMaxClock = 400000; // Fastest SCL the TWI sensor keeps up with, in Hz. 0 for no limit.
+static uint32_t twiGarbled; // Reads answered with garbage because SCL was above twiMaxClock
+static sim_twi_bus_t twiBus;
+static avr_cycle_count_t triggerGroup; // First trigger of the most recent group, triggers closer than SIMMINDUR belong together
+static avr_cycle_count_t triggerSkew; // Largest spread of the triggers in one group
+static uint32_t turnaround = 20; // micro-Seconds
+
+// Copies the frame the sensor holds at the current simulated time. Nodes on a bus are a scan apart from each other.
+static void sensorSnapshot(sim_sensor_t *s) {
+  uint64_t scan;
+  if(s->scanTime == 0) {
+    if(!s->triggered) s->scans++; // Scans on request, unless a trigger already did
+    s->triggered = 0;
+    scan = s->scans;
+  } else {
+    uint64_t cyclesPerScan = (uint64_t)s->avr->frequency / 1000 * s->scanTime;
+    scan = s->avr->cycle / cyclesPerScan;
+  }
+  memcpy(s->frame,simFrames[(scan + s->node) % SIMFRAMES],SIMFRAMESIZE);
+  s->index = 0;
+}
+// Length of a complete command starting with cmd, 0 if it is still incomplete or unknown
+static uint8_t commandComplete(const uint8_t *cmd, uint8_t length) {
+  switch(cmd[0]) {
+    case REQUESTDATA:
+    case I2CADDR:
+    case LEDUSAGE:
+      return length >= 3 ? 3 : 0;
+    case SCANTIME:
+      if(length >= 3 && cmd[2] == '\n') return 3;
+      return length >= 4 ? 4 : 0;
+    case BAUDRATE:
+      return length >= 5 ? 5 : 0;
+  }
+  return length > 0 ? 1 : 0; // Unknown byte, drop it
+}
+
+static void sensorCommand(sim_sensor_t *s, const uint8_t *cmd, uint8_t length) {
+  s->commands++;
+  if(verbose) {
+    fprintf(stderr,"%s: %10llu cycles, command",s->name,(unsigned long long)s->avr->cycle);
+    for(uint8_t i = 0; i < length; i++) fprintf(stderr," %02X",cmd[i]);
+    fprintf(stderr,"\n");
+  }
+  if(cmd[0] == REQUESTDATA && length == 3 && cmd[1] == 0) {
+    s->triggers++; // Protractor.trigger(): scan now, answer nothing
+    s->scans++;
+    s->triggered = 1;
+    s->triggerCycle = s->avr->cycle;
+    if(triggerGroup == 0 || s->triggerCycle - triggerGroup > (avr_cycle_count_t)s->avr->frequency / 1000 * SIMMINDUR) {
+      triggerGroup = s->triggerCycle;
+    } else if(s->triggerCycle - triggerGroup > triggerSkew) {
+      triggerSkew = s->triggerCycle - triggerGroup;
+    }
+  }
+  if(cmd[0] == SCANTIME) {
+    uint16_t ms = length == 3 ? cmd[1] : (uint16_t)(cmd[1] | (cmd[2] << 8));
+    s->scanTime = (ms > 0 && ms < SIMMINDUR) ? SIMMINDUR : ms;
+  }
+}
+
+/////// TWI ///////
+
+// SCL frequency the firmware has set up: F_CPU / (16 + 2 * TWBR * 4^prescaler)
+static uint32_t twiClock(avr_t *avr) {
+  uint32_t prescaler = 1 << (2 * (avr->data[0xB9] & 0x03)); // TWSR
+  return avr->frequency / (16 + 2 * avr->data[0xB8] * prescaler); // TWBR
+}
+
+static void twiHook(struct avr_irq_t *irq, uint32_t value, void *param) {
+  sim_sensor_t *s = (sim_sensor_t*)param;
+  avr_twi_msg_irq_t v;
+  v.u.v = value;
+  (void)irq;
+
+  if(v.u.twi.msg & TWI_COND_STOP) {
+    if(s->selected && !(s->selected & 1) && s->commandLength > 0) {
+      sensorCommand(s,s->command,s->commandLength); // One command per transaction
+    }
+    s->selected = 0;
+    if(twiBus.start) {
+      avr_cycle_count_t held = s->avr->cycle - twiBus.start;
+      twiBus.busy += held;
+      if(verbose) fprintf(stderr,"twi bus: %10llu cycles, held %.1f us\n",(unsigned long long)s->avr->cycle,held*1000000.0/s->avr->frequency);
+      twiBus.start = 0;
+    }
+  }
+  if(v.u.twi.msg & TWI_COND_START) {
+    if(twiBus.start) {
+      twiBus.repeatedStarts++;
+      if(s->selected && !(s->selected & 1) && s->commandLength > 0) {
+        sensorCommand(s,s->command,s->commandLength); // A repeated start ends the write as well
+      }
+    } else {
+      twiBus.start = s->avr->cycle;
+      twiBus.transactions++;
+    }
+    s->selected = 0;
+    s->commandLength = 0;
+    if((v.u.twi.addr >> 1) == SIMADDRESS) {
+      s->selected = v.u.twi.addr;
+      if(s->selected & 1) {
+        s->requests++;
+        sensorSnapshot(s);
+        if(twiMaxClock && twiClock(s->avr) > twiMaxClock) {
+          memset(s->frame,0xFF,sizeof(s->frame)); // Too fast for the sensor, every bit reads as released
+          twiGarbled++;
+        }
+      }
+      avr_raise_irq(s->irq + TWI_IRQ_INPUT,avr_twi_irq_msg(TWI_COND_ACK,s->selected,1));
+    }
+  }
+  if(s->selected) {
+    if(v.u.twi.msg & TWI_COND_WRITE) {
+      avr_raise_irq(s->irq + TWI_IRQ_INPUT,avr_twi_irq_msg(TWI_COND_ACK,s->selected,1));
+      if(s->commandLength < sizeof(s->command)) s->command[s->commandLength++] = v.u.twi.data;
+    }
+    if(v.u.twi.msg & TWI_COND_READ) {
+      uint8_t data = s->index < SIMFRAMESIZE ? s->frame[s->index++] : 0;
+      avr_raise_irq(s->irq + TWI_IRQ_INPUT,avr_twi_irq_msg(TWI_COND_READ,s->selected,data));
+    }
+  }
+}
+
+static const char *twiIrqNames[2] = {
+  [TWI_IRQ_INPUT] = "8>protractor.out",
+  [TWI_IRQ_OUTPUT] = "32<protractor.in",
+};
+
+static void attachTwi(avr_t *avr, sim_sensor_t *s) {
+  s->irq = avr_alloc_irq(&avr->irq_pool,0,2,twiIrqNames);
+  avr_irq_register_notify(s->irq + TWI_IRQ_OUTPUT,twiHook,s);
+  avr_connect_irq(s->irq + TWI_IRQ_INPUT,avr_io_getirq(avr,AVR_IOCTL_TWI_GETIRQ(0),TWI_IRQ_INPUT));
+  avr_connect_irq(avr_io_getirq(avr,AVR_IOCTL_TWI_GETIRQ(0),TWI_IRQ_OUTPUT),s->irq + TWI_IRQ_OUTPUT);
+}
+
+/////// USART ///////
+
+// CPU cycles one byte takes on the line: 10 bits at the baud rate the firmware has set up
+static avr_cycle_count_t byteCycles(avr_t *avr) {
+  uint16_t ubrr = avr->data[0xC4] | ((avr->data[0xC5] & 0x0F) << 8); // UBRR0L, UBRR0H
+  uint8_t u2x = avr->data[0xC0] & 0x02; // U2X0 in UCSR0A
+  return (avr_cycle_count_t)(u2x ? 8 : 16) * (ubrr + 1) * 10;
+}
+
+// Sends the scheduled answer, unless the firmware is still driving the bus
+static avr_cycle_count_t answerTimer(avr_t *avr, avr_cycle_count_t when, void *param) {
+  sim_bus_t *bus = (sim_bus_t*)param;
+  sim_sensor_t *s = bus->answering;
+  (void)avr; (void)when;
+  bus->answering = 0;
+  if(!s) return 0;
+  if(bus->multiDrop && bus->driving) {
+    s->lost++; // The host's transceiver is still sending, so the answer is never heard
+    return 0;
+  }
+  for(uint8_t i = 0; i < bus->answerLength; i++) avr_raise_irq(s->irq,s->frame[i]); // The USART paces these at the baud rate
+  return 0;
+}
+
+// Feeds one byte the firmware sent to sensor s
+static void uartCommand(sim_bus_t *bus, sim_sensor_t *s, uint8_t data) {
+  if(s->commandLength < sizeof(s->command)) s->command[s->commandLength++] = data;
+  uint8_t length = commandComplete(s->command,s->commandLength);
+  if(length == 0) return;
+  sensorCommand(s,s->command,length);
+  if(bus->multiDrop && bus->selected != RS485BROADCAST && s->command[0] == REQUESTDATA && length == 3 && s->command[1] == 0) {
+    // Nodes sit in a ring, each facing the nodes on either side of it
+    avr_cycle_count_t scanCycles = (avr_cycle_count_t)bus->avr->frequency / 1000 * SIMMINDUR;
+    for(uint8_t i = 0; i < bus->count; i++) {
+      sim_sensor_t *n = &bus->sensors[i];
+      uint8_t apart = n->node > s->node ? n->node - s->node : s->node - n->node;
+      if(apart != 1 && apart != bus->count - 1) continue;
+      if(n->triggers > 0 && n != s && s->triggerCycle - n->triggerCycle < scanCycles) bus->overlaps++;
+    }
+  }
+  // Nobody answers a broadcast, they would all talk at once
+  if(s->command[0] == REQUESTDATA && length == 3 && s->command[1] > 0 && s->command[2] == '\n' && bus->selected != RS485BROADCAST) {
+    s->requests++;
+    sensorSnapshot(s);
+    bus->answering = s;
+    bus->answerLength = s->command[1] > SIMFRAMESIZE ? SIMFRAMESIZE : s->command[1];
+    avr_cycle_count_t wait = bus->txEnd > bus->avr->cycle ? bus->txEnd - bus->avr->cycle : 0;
+    avr_cycle_timer_register(bus->avr,wait + avr_usec_to_cycles(bus->avr,turnaround) + 1,answerTimer,bus);
+  }
+  memmove(s->command,s->command+length,s->commandLength-length);
+  s->commandLength -= length;
+}
+
+static void uartHook(struct avr_irq_t *irq, uint32_t value, void *param) {
+  sim_bus_t *bus = (sim_bus_t*)param;
+  uint8_t data = (uint8_t)value;
+  (void)irq;
+  avr_cycle_count_t now = bus->avr->cycle;
+  bus->txEnd = (bus->txEnd > now ? bus->txEnd : now) + byteCycles(bus->avr);
+  if(!bus->multiDrop) {
+    uartCommand(bus,&bus->sensors[0],data);
+    return;
+  }
+  if(!bus->driving) {
+    bus->unheard++; // The transceiver is not enabled, the byte never reaches the bus
+    return;
+  }
+  if(data & RS485NODE) {
+    bus->selected = data & ~RS485NODE;
+    for(uint8_t i = 0; i < bus->count; i++) bus->sensors[i].commandLength = 0;
+    return;
+  }
+  for(uint8_t i = 0; i < bus->count; i++) {
+    sim_sensor_t *s = &bus->sensors[i];
+    if(bus->selected == s->node || bus->selected == RS485BROADCAST) uartCommand(bus,s,data);
+  }
+}
+
+static void directionHook(struct avr_irq_t *irq, uint32_t value, void *param) {
+  sim_bus_t *bus = (sim_bus_t*)param;
+  (void)irq;
+  if(bus->driving && !value && bus->avr->cycle < bus->txEnd) bus->truncated++; // Released before the last stop bit was out
+  bus->driving = value ? 1 : 0;
+}
+
+static void attachUart(avr_t *avr, sim_bus_t *bus, int directionPin) {
+  uint32_t flags = 0;
+  avr_ioctl(avr,AVR_IOCTL_UART_GET_FLAGS('0'),&flags);
+  flags &= ~AVR_UART_FLAG_STDIO; // USART0 belongs to the emulated sensors, not the terminal
+  avr_ioctl(avr,AVR_IOCTL_UART_SET_FLAGS('0'),&flags);
+  bus->avr = avr;
+  for(uint8_t i = 0; i < bus->count; i++) bus->sensors[i].irq = avr_io_getirq(avr,AVR_IOCTL_UART_GETIRQ('0'),UART_IRQ_INPUT);
+  avr_irq_register_notify(avr_io_getirq(avr,AVR_IOCTL_UART_GETIRQ('0'),UART_IRQ_OUTPUT),uartHook,bus);
+  if(bus->multiDrop) {
+    // Arduino pins 0 to 7 are on PORTD, 8 to 13 on PORTB
+    char port = directionPin < 8 ? 'D' : 'B';
+    int bit = directionPin < 8 ? directionPin : directionPin - 8;
+    avr_irq_register_notify(avr_io_getirq(avr,AVR_IOCTL_IOPORT_GETIRQ(port),bit),directionHook,bus);
+  }
+}
+
+/////// MAIN ///////
+
+static void sensorInit(sim_sensor_t *s, avr_t *avr, const char *name, uint8_t node) {
+  memset(s,0,sizeof(*s));
+  if(node) snprintf(s->name,sizeof(s->name),"%s.%u",name,node);
+  else snprintf(s->name,sizeof(s->name),"%s",name);
+  s->avr = avr;
+  s->node = node;
+  s->scanTime = SIMMINDUR;
+}
+
+static int usage(const char *name) {
+  fprintf(stderr,"usage: %s [-v] [-m nodes] [-d pin] [-t turnaround] [-c maxclock] firmware.elf\n",name);
+  return 2;
+}
+
+int main(int argc, char *argv[]) {
+  int nodes = 0;
+  int directionPin = 2;
+  int opt;
+  while((opt = getopt(argc,argv,"vm:d:t:c:")) != -1) {
+    switch(opt) {
+      case 'v': verbose = 1; break;
+      case 'm': nodes = atoi(optarg); break;
+      case 'd': directionPin = atoi(optarg); break;
+      case 't': turnaround = (uint32_t)atol(optarg); break;
+      case 'c': twiMaxClock = (uint32_t)atol(optarg); break;
+      default: return usage(argv[0]);
+    }
+  }
+  if(optind >= argc || nodes < 0 || nodes > SIMMAXNODES || directionPin < 0 || directionPin > 13) return usage(argv[0]);
+
+  elf_firmware_t firmware;
+  memset(&firmware,0,sizeof(firmware));
+  if(elf_read_firmware(argv[optind],&firmware) != 0) {
+    fprintf(stderr,"%s: can't load %s\n",argv[0],argv[optind]);
+    return 1;
+  }
+  if(firmware.frequency == 0) firmware.frequency = 16000000;
+  avr_t *avr = avr_make_mcu_by_name(firmware.mmcu[0] ? firmware.mmcu : "atmega328p");
+  if(!avr) {
+    fprintf(stderr,"%s: unknown mcu %s\n",argv[0],firmware.mmcu);
+    return 1;
+  }
+  avr_init(avr);
+  avr_load_firmware(avr,&firmware);
+
+  static sim_sensor_t twiSensor;
+  static sim_bus_t bus;
+  sensorInit(&twiSensor,avr,"twi",0);
+  attachTwi(avr,&twiSensor);
+  bus.multiDrop = nodes > 0;
+  bus.count = nodes > 0 ? nodes : 1;
+  for(uint8_t i = 0; i < bus.count; i++) sensorInit(&bus.sensors[i],avr,nodes > 0 ? "rs485" : "usart0",nodes > 0 ? i+1 : 0);
+  attachUart(avr,&bus,directionPin);
+
+  int state = cpu_Running;
+  while(state != cpu_Done && state != cpu_Crashed) state = avr_run(avr);
+
+  fprintf(stderr,"%s: %llu cycles, %.3f ms simulated\n",state == cpu_Crashed ? "crashed" : "done",
+    (unsigned long long)avr->cycle,avr->cycle*1000.0/avr->frequency);
+  fprintf(stderr,"  %-9s %u requests %u commands %u triggers %u garbled above %u Hz\n",twiSensor.name,twiSensor.requests,twiSensor.commands,twiSensor.triggers,twiGarbled,twiMaxClock);
+  fprintf(stderr,"  twi bus   %u transactions %u repeated starts, held %.1f us\n",twiBus.transactions,twiBus.repeatedStarts,twiBus.busy*1000000.0/avr->frequency);
+  for(uint8_t i = 0; i < bus.count; i++) {
+    sim_sensor_t *s = &bus.sensors[i];
+    fprintf(stderr,"  %-9s %u requests %u commands %u triggers %u answers lost\n",s->name,s->requests,s->commands,s->triggers,s->lost);
+  }
+  if(bus.multiDrop) fprintf(stderr,"  rs485     %u bytes sent with the bus released, %u transmissions cut short, %u triggered scans overlapped a neighbour's\n",bus.unheard,bus.truncated,bus.overlaps);
+  if(triggerGroup) fprintf(stderr,"  triggers  at most %.1f us apart within a group\n",triggerSkew*1000000.0/avr->frequency);
+  avr_terminate(avr);
+  return state == cpu_Crashed ? 1 : 0;
+}
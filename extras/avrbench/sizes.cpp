@@ -0,0 +1,66 @@
+/*
+  sizes.cpp - Smallest sketch that reads one data point, for comparing flash and SRAM between configurations
+  Copyright (c) 2017 William Moore.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+  ###########################################################################
+
+  The same sketch is built once per configuration, selected with SIZE_CONFIG:
+
+    SIZE_FULL   Protractor, read(1)
+    SIZE_LITE1  ProtractorLite<1>, a 5 byte frame
+    SIZE_LITE4  ProtractorLite<4>, a full 17 byte frame
+
+  "make size" prints the flash (text) and SRAM (data + bss) of each. They are not meant to be run.
+
+  ############################################################################
+*/
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "Protractor.h"
+#include "ProtractorLite.h"
+
+#define SIZE_FULL  0
+#define SIZE_LITE1 1
+#define SIZE_LITE4 2
+
+volatile int16_t sink; // Keeps the result from being optimized away
+
+#if SIZE_CONFIG == SIZE_FULL
+Protractor protractor;
+#else
+ProtractorWireTransport link;
+ProtractorLite<SIZE_CONFIG == SIZE_LITE1 ? 1 : 4> protractor;
+#endif
+
+void setup() {
+#if SIZE_CONFIG == SIZE_FULL
+  protractor.begin(Wire,0x45);
+#else
+  link.begin(Wire);
+  protractor.begin(link,0x45);
+#endif
+}
+
+void loop() {
+#if SIZE_CONFIG == SIZE_FULL
+  protractor.read(1);
+#else
+  protractor.read();
+#endif
+  sink = protractor.objectAngle();
+}
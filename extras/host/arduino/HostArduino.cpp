@@ -0,0 +1,188 @@
+/*
+  HostArduino.cpp - Minimal Arduino core for building the Protractor library on a PC
+  Copyright (c) 2017 William Moore.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <stdio.h>
+#include <time.h>
+#include "Arduino.h"
+#include "Wire.h"
+
+HardwareSerial Serial;
+TwoWire Wire;
+
+/////// TIME ///////
+
+static bool realTime = false;
+static unsigned long simulatedMicros = 0;
+
+static unsigned long clockMicros() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC,&now);
+  return (unsigned long)now.tv_sec*1000000UL + now.tv_nsec/1000;
+}
+
+void hostRealTime(bool on) {
+  realTime = on;
+}
+
+void hostClockAdvance(unsigned long us) {
+  simulatedMicros += us;
+}
+
+unsigned long micros() {
+  if(realTime) return clockMicros();
+  simulatedMicros += HOSTTICK;
+  return simulatedMicros;
+}
+
+unsigned long millis() {
+  return micros() / 1000;
+}
+
+void delay(unsigned long ms) {
+  delayMicroseconds(ms*1000);
+}
+
+void delayMicroseconds(unsigned int us) {
+  if(realTime){
+    unsigned long start = clockMicros();
+    while(clockMicros() - start < us);
+  }else{
+    simulatedMicros += us;
+  }
+}
+
+long map(long x, long in_min, long in_max, long out_min, long out_max) {
+  return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+void pinMode(uint8_t pin, uint8_t mode) { (void)pin; (void)mode; }
+void digitalWrite(uint8_t pin, uint8_t value) { (void)pin; (void)value; }
+int digitalRead(uint8_t pin) { (void)pin; return LOW; }
+
+/////// PRINT ///////
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+  size_t n = 0;
+  while(size--){
+    if(write(*buffer++)) n++;
+    else break;
+  }
+  return n;
+}
+
+size_t Print::print(const char str[]) { return write(str); }
+size_t Print::print(char c) { return write((uint8_t)c); }
+
+size_t Print::print(long n, int base) {
+  char text[24];
+  snprintf(text, sizeof(text), base == HEX ? "%lX" : "%ld", n);
+  return write(text);
+}
+
+size_t Print::print(unsigned long n, int base) {
+  char text[24];
+  snprintf(text, sizeof(text), base == HEX ? "%lX" : "%lu", n);
+  return write(text);
+}
+
+size_t Print::print(double n, int digits) {
+  char text[40];
+  snprintf(text, sizeof(text), "%.*f", digits, n);
+  return write(text);
+}
+
+size_t HardwareSerial::write(uint8_t data) {
+  return fwrite(&data,1,1,stdout);
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size) {
+  return fwrite(buffer,1,size,stdout);
+}
+
+/////// WIRE ///////
+
+TwoWire::TwoWire()
+{
+  for(uint8_t i = 0; i < HOSTI2CDEVICES; i++) _devices[i] = 0;
+  _txLength = 0;
+  _rxLength = 0;
+  _rxIndex = 0;
+}
+
+void TwoWire::attach(uint8_t address, HostI2CDevice *device) {
+  for(uint8_t i = 0; i < HOSTI2CDEVICES; i++){
+    if(_devices[i] == 0 || _addresses[i] == address){
+      _addresses[i] = address;
+      _devices[i] = device;
+      return;
+    }
+  }
+}
+
+HostI2CDevice* TwoWire::_device(uint8_t address) {
+  for(uint8_t i = 0; i < HOSTI2CDEVICES; i++){
+    if(_devices[i] != 0 && _addresses[i] == address) return _devices[i];
+  }
+  return 0;
+}
+
+void TwoWire::beginTransmission(uint8_t address) {
+  _txAddress = address;
+  _txLength = 0;
+}
+
+// Returns 0 on success and 2 if the address was not acknowledged, like the Arduino Wire library
+uint8_t TwoWire::endTransmission(uint8_t sendStop) {
+  (void)sendStop;
+  HostI2CDevice* device = _device(_txAddress);
+  if(device == 0) return 2;
+  device->receive(_txBuffer,_txLength);
+  _txLength = 0;
+  return 0;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, uint8_t sendStop) {
+  (void)sendStop;
+  if(quantity > BUFFER_LENGTH) quantity = BUFFER_LENGTH;
+  HostI2CDevice* device = _device(address);
+  _rxIndex = 0;
+  _rxLength = 0;
+  if(device == 0) return 0;
+  uint8_t sent = device->request(_rxBuffer,quantity);
+  for(uint8_t i = sent; i < quantity; i++) _rxBuffer[i] = 0xFF; // A real master keeps clocking; an idle bus reads as ones
+  _rxLength = quantity;
+  return quantity;
+}
+
+size_t TwoWire::write(uint8_t data) {
+  if(_txLength >= BUFFER_LENGTH) return 0;
+  _txBuffer[_txLength++] = data;
+  return 1;
+}
+
+size_t TwoWire::write(const uint8_t *data, size_t quantity) {
+  for(size_t i = 0; i < quantity; i++){
+    if(!write(data[i])) return i;
+  }
+  return quantity;
+}
+
+int TwoWire::available() { return _rxLength - _rxIndex; }
+int TwoWire::read() { return _rxIndex < _rxLength ? _rxBuffer[_rxIndex++] : -1; }
+int TwoWire::peek() { return _rxIndex < _rxLength ? _rxBuffer[_rxIndex] : -1; }
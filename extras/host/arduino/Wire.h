@@ -0,0 +1,76 @@
+/*
+  Wire.h - Minimal I2C bus for building the Protractor library on a PC
+  Copyright (c) 2017 William Moore.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+  ###########################################################################
+
+  A TwoWire with the same calls as the Arduino Wire library. Devices are simulated by attaching a
+  HostI2CDevice to an address; any address without a device does not acknowledge.
+
+  ############################################################################
+*/
+
+#ifndef TwoWire_h
+#define TwoWire_h
+
+#include "Arduino.h"
+
+#define BUFFER_LENGTH 32
+#define HOSTI2CDEVICES 8
+
+// A simulated device on the PC's I2C bus
+class HostI2CDevice
+{
+  public:
+    virtual ~HostI2CDevice() {}
+    virtual void receive(const uint8_t data[], uint8_t length) = 0; // Called with the bytes of a write transaction
+    virtual uint8_t request(uint8_t data[], uint8_t length) = 0; // Fill data with up to length bytes for a read transaction. Returns the number of bytes sent.
+};
+
+class TwoWire : public Stream
+{
+  public:
+    TwoWire();
+    void begin() {}
+    void setClock(uint32_t clock) { (void)clock; }
+    void attach(uint8_t address, HostI2CDevice *device); // Puts a simulated device on the bus
+    void beginTransmission(uint8_t address);
+    void beginTransmission(int address) { beginTransmission((uint8_t)address); }
+    uint8_t endTransmission(uint8_t sendStop = true);
+    uint8_t requestFrom(uint8_t address, uint8_t quantity, uint8_t sendStop = true);
+    uint8_t requestFrom(int address, int quantity) { return requestFrom((uint8_t)address, (uint8_t)quantity); }
+    virtual size_t write(uint8_t data);
+    virtual size_t write(const uint8_t *data, size_t quantity);
+    using Print::write;
+    virtual int available();
+    virtual int read();
+    virtual int peek();
+  private:
+    HostI2CDevice* _device(uint8_t address);
+    uint8_t _addresses[HOSTI2CDEVICES];
+    HostI2CDevice* _devices[HOSTI2CDEVICES];
+    uint8_t _txAddress;
+    uint8_t _txBuffer[BUFFER_LENGTH];
+    uint8_t _txLength;
+    uint8_t _rxBuffer[BUFFER_LENGTH];
+    uint8_t _rxLength;
+    uint8_t _rxIndex;
+};
+
+extern TwoWire Wire;
+
+#endif
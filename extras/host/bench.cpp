@@ -0,0 +1,121 @@
+/*
+  bench.cpp - Measures the Protractor library's own cost on a PC
+  Copyright (c) 2017 William Moore.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+  ###########################################################################
+
+  Usage: protractor_bench [-n iterations]
+
+  Reads go through a ProtractorLoopback, which answers every request from memory, so the numbers are
+  the cost of the library alone with no link or sensor in the way. Frames cycle through a small fixed
+  set so the accessors see changing counts. Each benchmark prints its wall-clock time per call:
+
+    BENCH <name> <nanoseconds>
+
+  For cycle counts on the robot's own processor, see extras/avrbench.
+
+  ############################################################################
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "Arduino.h"
+#include "Protractor.h"
+#include "ProtractorFilter.h"
+#include "ProtractorStabilizer.h"
+#include "ProtractorTransport.h"
+
+static const uint8_t benchFrames[][1+4*MAXOBJECTS] = {
+  { 0x23, 128,200, 40,180,  60,120, 220,90,   0,0, 0,0,       0,0, 0,0 },
+  { 0x32, 120,210, 45,170,  70,110, 230,80,   200,60, 0,0,    0,0, 0,0 },
+  { 0x44, 110,230, 30,200,  75,150, 210,120,  190,90, 128,60, 20,40, 100,30 },
+  { 0x01, 0,0, 128,250,     0,0, 0,0,         0,0, 0,0,       0,0, 0,0 },
+};
+#define BENCHFRAMES (sizeof(benchFrames)/sizeof(benchFrames[0]))
+
+static volatile long sink; // Keeps results from being optimized away
+
+static uint64_t wallNanos() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC,&now);
+  return (uint64_t)now.tv_sec*1000000000ULL + now.tv_nsec;
+}
+
+static void report(const char *name, uint64_t nanos, long calls) {
+  printf("BENCH %-20s %8.1f\n",name,(double)nanos/calls);
+}
+
+// Times code over iterations calls, with the loopback answering frame i % BENCHFRAMES
+#define BENCH(name, code) do { \
+    uint64_t start = wallNanos(); \
+    for(long i = 0; i < iterations; i++) { \
+      loopback.setFrame(benchFrames[i % BENCHFRAMES],sizeof(benchFrames[0])); \
+      code; \
+    } \
+    report(name, wallNanos() - start, iterations); \
+  } while(0)
+
+int main(int argc, char *argv[]) {
+  long iterations = 1000000;
+  int opt;
+  while((opt = getopt(argc,argv,"n:")) != -1) {
+    if(opt == 'n') iterations = atol(optarg);
+    else {
+      fprintf(stderr,"usage: %s [-n iterations]\n",argv[0]);
+      return 2;
+    }
+  }
+  if(iterations < 1) iterations = 1;
+
+  ProtractorLoopback loopback;
+  Protractor protractor;
+  protractor.begin(loopback);
+
+  BENCH("baseline", sink += i);
+  BENCH("read_4", protractor.read());
+  BENCH("read_1", protractor.read(1));
+  BENCH("startRead+complete", protractor.startRead(); sink += protractor.readComplete());
+  protractor.read();
+  BENCH("objectCount", sink += protractor.objectCount());
+  BENCH("pathCount", sink += protractor.pathCount());
+  BENCH("objectAngle", sink += protractor.objectAngle(i & 3));
+  BENCH("objectVisibility", sink += protractor.objectVisibility(i & 3));
+  BENCH("pathAngle", sink += protractor.pathAngle(i & 3));
+  BENCH("pathVisibility", sink += protractor.pathVisibility(i & 3));
+  BENCH("objectVectorXY", sink += protractor.objectVectorX(i & 3) + protractor.objectVectorY(i & 3));
+  ProtractorRunningSum<4> runningSum4;
+  ProtractorRunningSum<3> runningSum3;
+  ProtractorEMA<3> ema;
+  ProtractorMedian<5> median5;
+  ProtractorAlphaBeta<2,4> alphaBeta;
+  BENCH("runningSum4", runningSum4.add(protractor.objectAngleQ7(i & 3)); sink += runningSum4.average());
+  BENCH("runningSum3", runningSum3.add(protractor.objectAngleQ7(i & 3)); sink += runningSum3.average());
+  BENCH("ema", ema.add(protractor.objectAngleQ7(i & 3)); sink += ema.average());
+  BENCH("median5", median5.add(protractor.objectAngleQ7(i & 3)); sink += median5.median());
+  ProtractorStabilizer<3> stabilizer;
+  BENCH("stabilizer3", protractor.read(); stabilizer.update(protractor.frame(),protractor.frameLength()); sink += stabilizer.objectAngle(0));
+  BENCH("alphaBeta", alphaBeta.add(protractor.objectAngleQ7(i & 3)); sink += alphaBeta.value());
+  BENCH("read+all_accessors", protractor.read();
+    for(int ob = 0; ob < protractor.objectCount(); ob++) sink += protractor.objectAngle(ob) + protractor.objectVisibility(ob);
+    for(int pa = 0; pa < protractor.pathCount(); pa++) sink += protractor.pathAngle(pa) + protractor.pathVisibility(pa));
+  BENCH("scanTime", protractor.scanTime(MINDUR));
+
+  fprintf(stderr,"%lu reads, %lu commands through the loopback\n",(unsigned long)loopback.reads(),(unsigned long)loopback.commands());
+  return 0;
+}
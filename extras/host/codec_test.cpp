@@ -0,0 +1,205 @@
+/*
+  codec_test.cpp - Round trips frames through ProtractorFrameEncoder and ProtractorFrameDecoder
+  Copyright (c) 2017 William Moore.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+  ###########################################################################
+
+  Usage: protractor_codec_test [-n frames] [-s seed]
+
+  Every frame is encoded, decoded again and compared with the original. Every packet must also be no
+  longer than the keyframe of its frame, 1+length bytes. Run by "make test". The cases are:
+
+    empty        1 byte frames with no objects or paths. Their delta (type, mask) would be larger than
+                 the 2 byte keyframe.
+    random       frames of every length whose bytes drift by small and large steps, with the count byte
+                 changing now and then
+    worst        every byte of a full frame changes by -128 or 127, the two byte varint changes
+    lengths      the frame length changes from one frame to the next
+    timeouts     reads where the sensor did not answer, between deltas
+    lost         a delta that never arrives. The decoder must refuse what follows until the next keyframe.
+
+  Prints each failure and a summary, and exits with 1 if anything failed.
+
+  ############################################################################
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "ProtractorCodec.h"
+
+static const uint8_t LENGTHS[] = {1, 5, 9, 13, 17}; // Frames of 0 to 4 data points
+
+static uint32_t frames;
+static uint32_t failures;
+
+static void fail(const char *test, uint32_t frame, const char *what) {
+  if(failures < 20) printf("FAIL %-9s frame %lu: %s\n",test,(unsigned long)frame,what);
+  failures++;
+}
+
+// Encodes and decodes frame, and checks the result. Returns the packet size.
+static uint8_t roundTrip(const char *test, ProtractorFrameEncoder &encoder, ProtractorFrameDecoder &decoder, const uint8_t frame[], uint8_t length) {
+  uint8_t packet[CODECMAXPACKET+8];
+  uint8_t decoded[1+4*MAXOBJECTS];
+  memset(packet,0xEE,sizeof(packet));
+  uint8_t size = encoder.encode(frame,length,packet);
+  frames++;
+  if(size == 0 || size > CODECMAXPACKET) fail(test,frames,"packet size out of range");
+  if(size > (length == 0 ? 1 : 1+length)) fail(test,frames,"packet larger than the keyframe");
+  if(packet[CODECMAXPACKET] != 0xEE) fail(test,frames,"encoder wrote past CODECMAXPACKET");
+  uint8_t result = decoder.decode(packet,size,decoded);
+  if(result != length) fail(test,frames,"decoded length differs");
+  else if(memcmp(decoded,frame,length) != 0) fail(test,frames,"decoded bytes differ");
+  return size;
+}
+
+// A count byte (objects high nibble, paths low nibble) for the data points of length
+static uint8_t countByte(uint8_t length) {
+  uint8_t points = (length - 1) / 4;
+  return (uint8_t)((rand() % (points+1)) << 4 | (rand() % (points+1)));
+}
+
+static void testEmpty() {
+  ProtractorFrameEncoder encoder;
+  ProtractorFrameDecoder decoder;
+  uint8_t frame[1] = {0};
+  for(uint8_t i = 0; i < 40; i++) roundTrip("empty",encoder,decoder,frame,1);
+}
+
+static void testRandom(uint32_t count) {
+  ProtractorFrameEncoder encoder;
+  ProtractorFrameDecoder decoder;
+  uint8_t frame[1+4*MAXOBJECTS];
+  for(uint8_t length = 0; length < sizeof(LENGTHS); length++){
+    uint8_t n = LENGTHS[length];
+    frame[0] = countByte(n);
+    for(uint8_t i = 1; i < n; i++) frame[i] = rand();
+    for(uint32_t f = 0; f < count; f++){
+      if(rand() % 8 == 0) frame[0] = countByte(n);
+      for(uint8_t i = 1; i < n; i++){
+        int r = rand() % 16;
+        if(r < 8) continue; // Unchanged
+        if(r < 14) frame[i] += rand() % 129 - 64; // One varint byte
+        else frame[i] += rand(); // Any change, often two varint bytes
+      }
+      roundTrip("random",encoder,decoder,frame,n);
+    }
+  }
+}
+
+static void testWorst() {
+  ProtractorFrameEncoder encoder;
+  ProtractorFrameDecoder decoder;
+  uint8_t frame[1+4*MAXOBJECTS];
+  memset(frame,0,sizeof(frame));
+  frame[0] = 0x44;
+  for(uint8_t f = 0; f < 64; f++){
+    for(uint8_t i = 1; i < sizeof(frame); i++) frame[i] += (f & 1) ? 127 : -128;
+    if(f & 2) frame[0] ^= 0x11;
+    roundTrip("worst",encoder,decoder,frame,sizeof(frame));
+  }
+  // Two bytes change as far as they can and the rest stay put: the largest delta that is still sent
+  for(uint8_t f = 0; f < 64; f++){
+    frame[1+f%16] += 128;
+    frame[1+(f+5)%16] += 127;
+    roundTrip("worst",encoder,decoder,frame,sizeof(frame));
+  }
+}
+
+static void testLengths(uint32_t count) {
+  ProtractorFrameEncoder encoder;
+  ProtractorFrameDecoder decoder;
+  uint8_t frame[1+4*MAXOBJECTS];
+  for(uint8_t i = 0; i < sizeof(frame); i++) frame[i] = rand();
+  for(uint32_t f = 0; f < count; f++){
+    uint8_t n = LENGTHS[rand() % sizeof(LENGTHS)];
+    frame[0] = countByte(n);
+    frame[1+rand()%16] += rand() % 7 - 3;
+    roundTrip("lengths",encoder,decoder,frame,n);
+  }
+}
+
+static void testTimeouts(uint32_t count) {
+  ProtractorFrameEncoder encoder;
+  ProtractorFrameDecoder decoder;
+  uint8_t frame[1+4*MAXOBJECTS];
+  for(uint8_t i = 0; i < sizeof(frame); i++) frame[i] = rand();
+  for(uint32_t f = 0; f < count; f++){
+    if(rand() % 4 == 0){
+      roundTrip("timeouts",encoder,decoder,frame,0);
+      continue;
+    }
+    frame[1+rand()%16] += rand() % 7 - 3;
+    roundTrip("timeouts",encoder,decoder,frame,sizeof(frame));
+  }
+}
+
+static void testLost() {
+  ProtractorFrameEncoder encoder;
+  ProtractorFrameDecoder decoder;
+  uint8_t frame[1+4*MAXOBJECTS];
+  uint8_t packet[CODECMAXPACKET];
+  uint8_t decoded[1+4*MAXOBJECTS];
+  for(uint8_t i = 0; i < sizeof(frame); i++) frame[i] = rand();
+  roundTrip("lost",encoder,decoder,frame,sizeof(frame));
+  roundTrip("lost",encoder,decoder,frame,sizeof(frame));
+  frame[3]++;
+  encoder.encode(frame,sizeof(frame),packet); // Never reaches the decoder
+  for(uint8_t f = 0; f < 40; f++){
+    frame[3]++;
+    uint8_t size = encoder.encode(frame,sizeof(frame),packet);
+    uint8_t result = decoder.decode(packet,size,decoded);
+    frames++;
+    bool keyframe = (packet[0] & CODECKEYFRAME) != 0;
+    if(!keyframe && result != CODECERROR) fail("lost",frames,"delta after a lost packet was decoded");
+    if(keyframe && (result != sizeof(frame) || memcmp(decoded,frame,sizeof(frame)) != 0)) fail("lost",frames,"keyframe after a lost packet was not decoded");
+    if(keyframe) break;
+    if(f == 39) fail("lost",frames,"no keyframe within 40 packets");
+  }
+  for(uint8_t f = 0; f < 20; f++){ // In step again
+    frame[7]--;
+    roundTrip("lost",encoder,decoder,frame,sizeof(frame));
+  }
+}
+
+int main(int argc, char *argv[]) {
+  long count = 20000;
+  unsigned seed = 1;
+  int option;
+  while((option = getopt(argc,argv,"n:s:")) != -1){
+    switch(option){
+      case 'n': count = atol(optarg); break;
+      case 's': seed = (unsigned)atol(optarg); break;
+      default:
+        fprintf(stderr,"usage: %s [-n frames] [-s seed]\n",argv[0]);
+        return 2;
+    }
+  }
+  srand(seed);
+
+  testEmpty();
+  testRandom((uint32_t)count);
+  testWorst();
+  testLengths((uint32_t)count);
+  testTimeouts((uint32_t)count);
+  testLost();
+
+  printf("codec: %lu frames, %lu failures\n",(unsigned long)frames,(unsigned long)failures);
+  return failures == 0 ? 0 : 1;
+}
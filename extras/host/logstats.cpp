@@ -0,0 +1,366 @@
+/*
+  logstats.cpp - Batch statistics over recorded Protractor frame logs
+  Copyright (c) 2017 William Moore.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+  ###########################################################################
+
+  Usage: protractor_logstats [-j threads] [-H] log...
+
+  Reads any number of frame logs made by ProtractorRecorder and reports, per file and over all files:
+  timeouts and lost records, how often objects and paths were detected, their mean visibility, the time
+  between frames, and a histogram of object and path angles.
+
+    -j threads   number of files processed at once (default: one per CPU)
+    -H           print the full 256 bin angle histograms as CSV instead of the 10 degree summary
+
+  Each log is memory mapped and its records are unpacked in one pass into columns: one array per field
+  (object count, angle of slot 0, visibility of slot 0, ...), with unused slots set to zero. The
+  statistics are then computed by simple loops over the 8-bit columns, which the compiler turns into
+  vector instructions.
+
+  ############################################################################
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "ProtractorLog.h"
+
+#define SLOTS 4 // Data points per frame, MAXOBJECTS
+
+// One log unpacked into columns
+struct FrameColumns
+{
+  std::vector<uint32_t> timestamp;
+  std::vector<uint32_t> sequence;
+  std::vector<uint8_t> received; // Number of frame bytes received, 0 for a timeout
+  std::vector<size_t> offset; // Where the record starts in the log
+  std::vector<uint8_t> objects; // Object count, high nibble of byte 0
+  std::vector<uint8_t> paths; // Path count, low nibble of byte 0
+  std::vector<uint8_t> objectAngle[SLOTS];
+  std::vector<uint8_t> objectVisibility[SLOTS];
+  std::vector<uint8_t> pathAngle[SLOTS];
+  std::vector<uint8_t> pathVisibility[SLOTS];
+};
+
+// Statistics of one or more logs. Everything is a sum or count, so results of several logs simply add up.
+struct LogStats
+{
+  uint64_t frames;
+  uint64_t timeouts;
+  uint64_t lost; // Records missing according to the sequence numbers
+  uint64_t skipped; // Damaged bytes
+  uint64_t withObject; // Frames with at least one object
+  uint64_t withPath; // Frames with at least one path
+  uint64_t objectSlots; // Objects seen, over all frames
+  uint64_t pathSlots;
+  uint64_t objectVisibility; // Sum of the visibility of every object seen
+  uint64_t pathVisibility;
+  uint64_t objectHistogram[256]; // Objects seen at each raw angle
+  uint64_t pathHistogram[256];
+  std::vector<uint32_t> intervals; // Micro-seconds between consecutive frames
+  bool valid;
+};
+
+static void clearStats(LogStats &stats) {
+  stats.frames = 0;
+  stats.timeouts = 0;
+  stats.lost = 0;
+  stats.skipped = 0;
+  stats.withObject = 0;
+  stats.withPath = 0;
+  stats.objectSlots = 0;
+  stats.pathSlots = 0;
+  stats.objectVisibility = 0;
+  stats.pathVisibility = 0;
+  memset(stats.objectHistogram,0,sizeof(stats.objectHistogram));
+  memset(stats.pathHistogram,0,sizeof(stats.pathHistogram));
+  stats.intervals.clear();
+  stats.valid = false;
+}
+
+static void addStats(LogStats &total, const LogStats &stats) {
+  total.frames += stats.frames;
+  total.timeouts += stats.timeouts;
+  total.lost += stats.lost;
+  total.skipped += stats.skipped;
+  total.withObject += stats.withObject;
+  total.withPath += stats.withPath;
+  total.objectSlots += stats.objectSlots;
+  total.pathSlots += stats.pathSlots;
+  total.objectVisibility += stats.objectVisibility;
+  total.pathVisibility += stats.pathVisibility;
+  for(int a = 0; a < 256; a++){
+    total.objectHistogram[a] += stats.objectHistogram[a];
+    total.pathHistogram[a] += stats.pathHistogram[a];
+  }
+  total.intervals.insert(total.intervals.end(),stats.intervals.begin(),stats.intervals.end());
+  total.valid = total.valid || stats.valid;
+}
+
+/////// DECODING ///////
+
+// Unpacks every record of a mapped log into columns. Returns false if data is not a frame log.
+static bool decodeLog(const uint8_t *data, size_t size, FrameColumns &columns, uint64_t &skipped) {
+  if(size < LOGHEADERSIZE || !ProtractorLog::checkHeader(data)) return false;
+  size_t estimate = (size - LOGHEADERSIZE) / LOGRECORDSIZE;
+  columns.timestamp.reserve(estimate);
+  columns.sequence.reserve(estimate);
+  columns.received.reserve(estimate);
+  columns.offset.reserve(estimate);
+  skipped = 0;
+  size_t position = LOGHEADERSIZE;
+  ProtractorLogRecord record;
+  while(position < size){
+    uint32_t chunk = size - position > 0xFFFFFFF0u ? 0xFFFFFFF0u : (uint32_t)(size - position);
+    uint32_t skip;
+    uint32_t used = ProtractorLog::readRecord(data+position,chunk,record,skip);
+    if(used == 0) break;
+    columns.offset.push_back(position+skip);
+    position += used;
+    skipped += skip;
+    columns.timestamp.push_back(record.timestamp);
+    columns.sequence.push_back(record.sequence);
+    columns.received.push_back(record.length);
+  }
+  // Second pass: the frame bytes are copied straight out of the map into their columns
+  size_t frames = columns.timestamp.size();
+  columns.objects.assign(frames,0);
+  columns.paths.assign(frames,0);
+  for(int s = 0; s < SLOTS; s++){
+    columns.objectAngle[s].assign(frames,0);
+    columns.objectVisibility[s].assign(frames,0);
+    columns.pathAngle[s].assign(frames,0);
+    columns.pathVisibility[s].assign(frames,0);
+  }
+  for(size_t f = 0; f < frames; f++){
+    const uint8_t *frame = data + columns.offset[f] + LOGRECORDSIZE;
+    uint8_t length = columns.received[f];
+    if(length > 0){ // Only slots actually received are counted, so read(1) logs show no phantom objects
+      uint8_t points = (length - 1) / 4;
+      if(points > SLOTS) points = SLOTS;
+      columns.objects[f] = std::min<uint8_t>(frame[0] >> 4, points);
+      columns.paths[f] = std::min<uint8_t>(frame[0] & 0x0F, points);
+    }
+    for(int s = 0; s < SLOTS && 4+4*s < length; s++){
+      columns.objectAngle[s][f] = frame[1+4*s];
+      columns.objectVisibility[s][f] = frame[2+4*s];
+      columns.pathAngle[s][f] = frame[3+4*s];
+      columns.pathVisibility[s][f] = frame[4+4*s];
+    }
+  }
+  return true;
+}
+
+/////// STATISTICS ///////
+
+// Sum of visibility[f] over the frames where slot is below count[f]. Written as a plain loop over 8-bit
+// columns so that it vectorizes.
+static uint64_t maskedSum(const uint8_t *count, const uint8_t *visibility, size_t frames, uint8_t slot) {
+  uint64_t sum = 0;
+  size_t f = 0;
+  while(f < frames){
+    size_t block = std::min(frames - f, (size_t)65536); // 65536*255 fits the 32-bit partial sum
+    uint32_t partial = 0;
+    for(size_t i = f; i < f + block; i++){
+      partial += count[i] > slot ? visibility[i] : 0;
+    }
+    sum += partial;
+    f += block;
+  }
+  return sum;
+}
+
+// Number of frames where count[f] is greater than slot
+static uint64_t countAbove(const uint8_t *count, size_t frames, uint8_t slot) {
+  uint64_t n = 0;
+  for(size_t i = 0; i < frames; i++) n += count[i] > slot;
+  return n;
+}
+
+// Adds the angles of the frames where slot is below count[f] to histogram. Four sub-histograms keep
+// consecutive increments of the same bin from waiting on each other.
+static void maskedHistogram(const uint8_t *count, const uint8_t *angle, size_t frames, uint8_t slot, uint64_t histogram[256]) {
+  uint32_t sub[4][257];
+  memset(sub,0,sizeof(sub));
+  size_t i = 0;
+  for(; i + 4 <= frames; i += 4){
+    sub[0][count[i]   > slot ? angle[i]   : 256]++;
+    sub[1][count[i+1] > slot ? angle[i+1] : 256]++;
+    sub[2][count[i+2] > slot ? angle[i+2] : 256]++;
+    sub[3][count[i+3] > slot ? angle[i+3] : 256]++;
+  }
+  for(; i < frames; i++) sub[0][count[i] > slot ? angle[i] : 256]++;
+  for(int a = 0; a < 256; a++) histogram[a] += (uint64_t)sub[0][a] + sub[1][a] + sub[2][a] + sub[3][a];
+}
+
+static void computeStats(const FrameColumns &columns, LogStats &stats) {
+  size_t frames = columns.timestamp.size();
+  stats.frames = frames;
+  stats.valid = true;
+  for(size_t f = 0; f < frames; f++){
+    stats.timeouts += columns.received[f] == 0;
+  }
+  for(size_t f = 1; f < frames; f++){
+    uint32_t step = columns.sequence[f] - columns.sequence[f-1];
+    if(step > 1) stats.lost += step - 1;
+  }
+  stats.intervals.resize(frames > 0 ? frames - 1 : 0);
+  for(size_t f = 1; f < frames; f++){
+    stats.intervals[f-1] = columns.timestamp[f] - columns.timestamp[f-1];
+  }
+  const uint8_t *objects = columns.objects.data();
+  const uint8_t *paths = columns.paths.data();
+  stats.withObject = countAbove(objects,frames,0);
+  stats.withPath = countAbove(paths,frames,0);
+  for(uint8_t s = 0; s < SLOTS; s++){
+    stats.objectSlots += countAbove(objects,frames,s);
+    stats.pathSlots += countAbove(paths,frames,s);
+    stats.objectVisibility += maskedSum(objects,columns.objectVisibility[s].data(),frames,s);
+    stats.pathVisibility += maskedSum(paths,columns.pathVisibility[s].data(),frames,s);
+    maskedHistogram(objects,columns.objectAngle[s].data(),frames,s,stats.objectHistogram);
+    maskedHistogram(paths,columns.pathAngle[s].data(),frames,s,stats.pathHistogram);
+  }
+}
+
+static bool processFile(const char *path, LogStats &stats) {
+  clearStats(stats);
+  int fd = open(path,O_RDONLY);
+  if(fd < 0) return false;
+  struct stat info;
+  if(fstat(fd,&info) != 0 || info.st_size == 0){
+    close(fd);
+    return false;
+  }
+  void *map = mmap(0,info.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+  close(fd);
+  if(map == MAP_FAILED) return false;
+  madvise(map,info.st_size,MADV_SEQUENTIAL);
+  FrameColumns columns;
+  bool ok = decodeLog((const uint8_t*)map,info.st_size,columns,stats.skipped);
+  munmap(map,info.st_size);
+  if(ok) computeStats(columns,stats);
+  return ok;
+}
+
+/////// REPORT ///////
+
+static double percent(uint64_t part, uint64_t whole) {
+  return whole ? 100.0 * part / whole : 0.0;
+}
+
+static void printStats(const char *name, LogStats &stats) {
+  printf("%s\n",name);
+  printf("  frames %llu, timeouts %llu (%.2f%%), lost records %llu, damaged bytes %llu\n",
+    (unsigned long long)stats.frames,(unsigned long long)stats.timeouts,percent(stats.timeouts,stats.frames),
+    (unsigned long long)stats.lost,(unsigned long long)stats.skipped);
+  printf("  object detected in %.2f%% of frames, %.2f per frame, mean visibility %.1f\n",
+    percent(stats.withObject,stats.frames),stats.frames ? (double)stats.objectSlots/stats.frames : 0.0,
+    stats.objectSlots ? (double)stats.objectVisibility/stats.objectSlots : 0.0);
+  printf("  path detected in %.2f%% of frames, %.2f per frame, mean visibility %.1f\n",
+    percent(stats.withPath,stats.frames),stats.frames ? (double)stats.pathSlots/stats.frames : 0.0,
+    stats.pathSlots ? (double)stats.pathVisibility/stats.pathSlots : 0.0);
+  std::vector<uint32_t> &intervals = stats.intervals;
+  if(!intervals.empty()){
+    std::sort(intervals.begin(),intervals.end());
+    uint64_t sum = 0;
+    for(size_t i = 0; i < intervals.size(); i++) sum += intervals[i];
+    size_t n = intervals.size();
+    printf("  frame interval us: mean %.0f, min %u, median %u, 99%% %u, max %u\n",(double)sum/n,
+      intervals[0],intervals[n/2],intervals[std::min(n-1,n*99/100)],intervals[n-1]);
+  }
+}
+
+// Angle histograms in 10 degree bins. Raw angles 0 to 255 cover 0 to 180 degrees.
+static void printHistograms(const LogStats &stats, bool full) {
+  if(full){
+    printf("raw,degrees,objects,paths\n");
+    for(int a = 0; a < 256; a++){
+      printf("%d,%.1f,%llu,%llu\n",a,a*180.0/255,(unsigned long long)stats.objectHistogram[a],(unsigned long long)stats.pathHistogram[a]);
+    }
+    return;
+  }
+  uint64_t objects[18] = {0};
+  uint64_t paths[18] = {0};
+  for(int a = 0; a < 256; a++){
+    int bin = std::min(a*180/255/10,17);
+    objects[bin] += stats.objectHistogram[a];
+    paths[bin] += stats.pathHistogram[a];
+  }
+  printf("  degrees    objects      paths\n");
+  for(int b = 0; b < 18; b++){
+    printf("  %3d-%-3d %10llu %10llu\n",b*10,b*10+9+(b == 17),(unsigned long long)objects[b],(unsigned long long)paths[b]);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  unsigned threads = std::thread::hardware_concurrency();
+  bool fullHistogram = false;
+  int option;
+  while((option = getopt(argc,argv,"j:H")) != -1){
+    switch(option){
+      case 'j': threads = atoi(optarg); break;
+      case 'H': fullHistogram = true; break;
+      default:
+        fprintf(stderr,"usage: %s [-j threads] [-H] log...\n",argv[0]);
+        return 2;
+    }
+  }
+  int files = argc - optind;
+  if(files <= 0){
+    fprintf(stderr,"usage: %s [-j threads] [-H] log...\n",argv[0]);
+    return 2;
+  }
+  if(threads < 1) threads = 1;
+  if(threads > (unsigned)files) threads = files;
+
+  // Each worker takes the next file until none are left
+  std::vector<LogStats> results(files);
+  std::atomic<int> next(0);
+  std::vector<std::thread> workers;
+  for(unsigned t = 0; t < threads; t++){
+    workers.push_back(std::thread([&](){
+      int i;
+      while((i = next++) < files) processFile(argv[optind+i],results[i]);
+    }));
+  }
+  for(unsigned t = 0; t < threads; t++) workers[t].join();
+
+  LogStats total;
+  clearStats(total);
+  int failed = 0;
+  for(int i = 0; i < files; i++){
+    if(!results[i].valid){
+      fprintf(stderr,"%s: not a Protractor frame log\n",argv[optind+i]);
+      failed++;
+      continue;
+    }
+    if(!fullHistogram) printStats(argv[optind+i],results[i]);
+    addStats(total,results[i]);
+  }
+  if(!fullHistogram && files - failed > 1) printStats("all files",total);
+  printHistograms(total,fullHistogram);
+  return failed ? 1 : 0;
+}
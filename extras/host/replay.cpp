@@ -0,0 +1,154 @@
+/*
+  replay.cpp - Runs strategy code against a recorded Protractor frame log on a PC
+  Copyright (c) 2017 William Moore.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+  ###########################################################################
+
+  Usage: protractor_replay [-s speed] [-n dataPoints] [-r] [-v] log
+
+  Every record of the log is played through the unchanged Protractor.read(), then handed to
+  protractorStrategy(). Build with "make STRATEGY=mystrategy.cpp" to link your own strategy; the default
+  one only adds up the angles it sees. By default each read() gets the next record. With -s the records
+  are paced at their recorded timing, and reads made before the next record is due get the current one
+  again. Time is simulated unless -r is given, so a replay with -s 1 keeps the recorded timing yet runs
+  many times faster than real-time. At the end the wall-clock cost of read()
+  and of the strategy is reported per frame.
+
+    -s speed       0 = next record on every read (default), 1 = recorded timing, N = N times faster
+    -n dataPoints  number of objects and paths requested by each read(), 1 to 4 (default 4)
+    -r             follow the PC's clock instead of simulated time
+    -v             print every record
+
+  ############################################################################
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "Arduino.h"
+#include "Protractor.h"
+#include "ProtractorReplay.h"
+
+// Strategy code under test, called once per frame. Linking a file that defines it replaces this one.
+void protractorStrategy(Protractor &protractor) __attribute__((weak));
+
+static volatile long strategySink;
+
+void protractorStrategy(Protractor &protractor) {
+  long sum = 0;
+  for(int i = 0; i < protractor.objectCount(); i++) sum += protractor.objectAngle(i);
+  for(int i = 0; i < protractor.pathCount(); i++) sum += protractor.pathAngle(i);
+  strategySink = sum;
+}
+
+static uint64_t wallNanos() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC,&now);
+  return (uint64_t)now.tv_sec*1000000000ULL + now.tv_nsec;
+}
+
+static uint8_t* loadFile(const char *path, uint32_t &size) {
+  FILE *file = fopen(path,"rb");
+  if(file == 0) return 0;
+  fseek(file,0,SEEK_END);
+  size = (uint32_t)ftell(file);
+  fseek(file,0,SEEK_SET);
+  uint8_t *data = (uint8_t*)malloc(size ? size : 1);
+  if(data != 0 && fread(data,1,size,file) != size){
+    free(data);
+    data = 0;
+  }
+  fclose(file);
+  return data;
+}
+
+int main(int argc, char *argv[]) {
+  int speed = 0;
+  int dataPoints = MAXOBJECTS;
+  bool verbose = false;
+  int option;
+  while((option = getopt(argc,argv,"s:n:rv")) != -1){
+    switch(option){
+      case 's': speed = atoi(optarg); break;
+      case 'n': dataPoints = atoi(optarg); break;
+      case 'r': hostRealTime(true); break;
+      case 'v': verbose = true; break;
+      default:
+        fprintf(stderr,"usage: %s [-s speed] [-n dataPoints] [-r] [-v] log\n",argv[0]);
+        return 2;
+    }
+  }
+  if(optind >= argc){
+    fprintf(stderr,"usage: %s [-s speed] [-n dataPoints] [-r] [-v] log\n",argv[0]);
+    return 2;
+  }
+
+  uint32_t size = 0;
+  uint8_t *log = loadFile(argv[optind],size);
+  if(log == 0){
+    fprintf(stderr,"%s: cannot read %s\n",argv[0],argv[optind]);
+    return 1;
+  }
+
+  ProtractorReplayStream replay;
+  if(!replay.begin(log,size,(uint16_t)speed)){
+    fprintf(stderr,"%s: %s is not a Protractor frame log\n",argv[0],argv[optind]);
+    return 1;
+  }
+  Protractor protractor;
+  protractor.begin(replay);
+
+  uint32_t frames = 0;
+  uint32_t timeouts = 0;
+  uint32_t printed = 0; // Records printed with -v; a paced replay hands the same record to several reads
+  uint64_t readNanos = 0;
+  uint64_t strategyNanos = 0;
+  unsigned long simulatedStart = micros();
+  uint64_t wallStart = wallNanos();
+  while(!replay.finished()){
+    uint64_t t0 = wallNanos();
+    bool received = protractor.read(dataPoints);
+    uint64_t t1 = wallNanos();
+    protractorStrategy(protractor);
+    uint64_t t2 = wallNanos();
+    readNanos += t1 - t0;
+    strategyNanos += t2 - t1;
+    frames++;
+    if(!received) timeouts++;
+    if(verbose && replay.played() != printed){
+      printed = replay.played();
+      printf("%10lu  objects %d  paths %d ", (unsigned long)replay.timestamp(), protractor.objectCount(), protractor.pathCount());
+      for(int i = 0; i < protractor.objectCount(); i++) printf(" o%d=%d/%d",i,protractor.objectAngle(i),protractor.objectVisibility(i));
+      for(int i = 0; i < protractor.pathCount(); i++) printf(" p%d=%d/%d",i,protractor.pathAngle(i),protractor.pathVisibility(i));
+      printf("%s\n", received ? "" : "  (timeout)");
+    }
+  }
+  uint64_t wallTotal = wallNanos() - wallStart;
+  unsigned long simulated = micros() - simulatedStart;
+
+  printf("records played   %lu (%lu damaged bytes skipped)\n",(unsigned long)replay.played(),(unsigned long)replay.skipped());
+  printf("reads            %lu (%lu timed out)\n",(unsigned long)frames,(unsigned long)timeouts);
+  printf("sensor time      %.3f s\n",simulated/1e6);
+  printf("wall time        %.3f s (%.1fx real-time)\n",wallTotal/1e9,wallTotal ? simulated*1e3/wallTotal : 0.0);
+  if(frames > 0){
+    printf("read()           %.0f ns/frame\n",(double)readNanos/frames);
+    printf("strategy         %.0f ns/frame\n",(double)strategyNanos/frames);
+  }
+  free(log);
+  return 0;
+}
@@ -0,0 +1,185 @@
+/*
+  telemetry.cpp - Rebuilds Protractor frames from ProtractorTelemetry packets on a PC
+  Copyright (c) 2017 William Moore.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+  ###########################################################################
+
+  Usage: protractor_telemetry [-b baud] [-o log] [-q] [device]
+
+  Reads ProtractorTelemetry packets from a serial device (or standard input if no device is given),
+  rebuilds the frames and prints one line per frame. With -o the frames are also written to a frame log
+  that protractor_replay and protractor_logstats can read.
+
+    -b baud   baud rate of the serial device (default 115200)
+    -o log    also write the frames to this frame log
+    -q        do not print the frames
+
+  ############################################################################
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include "Arduino.h"
+#include "ProtractorCodec.h"
+#include "ProtractorLog.h"
+#include "ProtractorRecorder.h"
+#include "ProtractorTelemetry.h"
+
+// A Print that writes to a file
+class FilePrint : public Print
+{
+  public:
+    FilePrint(FILE *file) : _file(file) {}
+    virtual size_t write(uint8_t data) { return fwrite(&data,1,1,_file); }
+    virtual size_t write(const uint8_t *buffer, size_t size) { return fwrite(buffer,1,size,_file); }
+    virtual void flush() { fflush(_file); }
+  private:
+    FILE *_file;
+};
+
+static speed_t baudConstant(long baud) {
+  switch(baud){
+    case 1200: return B1200;
+    case 2400: return B2400;
+    case 4800: return B4800;
+    case 9600: return B9600;
+    case 19200: return B19200;
+    case 38400: return B38400;
+    case 57600: return B57600;
+    case 115200: return B115200;
+    case 230400: return B230400;
+    default: return 0;
+  }
+}
+
+static int openSerial(const char *device, long baud) {
+  int fd = open(device,O_RDONLY | O_NOCTTY);
+  if(fd < 0) return -1;
+  struct termios settings;
+  if(tcgetattr(fd,&settings) == 0){
+    cfmakeraw(&settings);
+    speed_t speed = baudConstant(baud);
+    if(speed != 0){
+      cfsetispeed(&settings,speed);
+      cfsetospeed(&settings,speed);
+    }
+    settings.c_cc[VMIN] = 1;
+    settings.c_cc[VTIME] = 0;
+    tcsetattr(fd,TCSANOW,&settings);
+  }
+  return fd;
+}
+
+int main(int argc, char *argv[]) {
+  long baud = 115200;
+  const char *logPath = 0;
+  bool quiet = false;
+  int option;
+  while((option = getopt(argc,argv,"b:o:q")) != -1){
+    switch(option){
+      case 'b': baud = atol(optarg); break;
+      case 'o': logPath = optarg; break;
+      case 'q': quiet = true; break;
+      default:
+        fprintf(stderr,"usage: %s [-b baud] [-o log] [-q] [device]\n",argv[0]);
+        return 2;
+    }
+  }
+  int fd = 0;
+  if(optind < argc){
+    fd = openSerial(argv[optind],baud);
+    if(fd < 0){
+      fprintf(stderr,"%s: cannot open %s\n",argv[0],argv[optind]);
+      return 1;
+    }
+  }
+
+  FILE *logFile = 0;
+  FilePrint *logPrint = 0;
+  ProtractorRecorder recorder;
+  if(logPath != 0){
+    logFile = fopen(logPath,"wb");
+    if(logFile == 0){
+      fprintf(stderr,"%s: cannot create %s\n",argv[0],logPath);
+      return 1;
+    }
+    logPrint = new FilePrint(logFile);
+    recorder.begin(*logPrint);
+  }
+
+  ProtractorFrameDecoder decoder;
+  uint8_t packet[TELEMETRYMAXPACKET];
+  uint8_t have = 0;
+  uint32_t frames = 0;
+  uint32_t damaged = 0;
+  uint32_t undecodable = 0;
+  uint32_t time = 0; // Sender's millis(), unwrapped from 16 bits
+  bool timeKnown = false;
+  uint8_t input[256];
+  ssize_t got;
+  while((got = read(fd,input,sizeof(input))) > 0){
+    for(ssize_t n = 0; n < got; n++){
+      if(have == 0 && input[n] != TELEMETRYSYNC) continue; // Hunt for the start of a packet
+      packet[have++] = input[n];
+      if(have == 2 && packet[1] > CODECMAXPACKET){
+        have = 0; // Not a real packet start
+        damaged++;
+        continue;
+      }
+      if(have < 2 || have < 5 + packet[1]) continue;
+
+      uint8_t size = packet[1];
+      have = 0;
+      if(ProtractorLog::crc8(packet+1,3+size) != packet[4+size]){
+        damaged++;
+        continue;
+      }
+      uint16_t stamp = packet[2] | (packet[3] << 8);
+      time = timeKnown ? time + (uint16_t)(stamp - (uint16_t)time) : stamp;
+      timeKnown = true;
+
+      uint8_t frame[1+4*MAXOBJECTS];
+      uint8_t length = decoder.decode(packet+4,size,frame);
+      if(length == CODECERROR){
+        undecodable++;
+        continue;
+      }
+      frames++;
+      if(logPrint != 0) recorder.record(frame,length,time*1000);
+      if(!quiet){
+        uint8_t objects = length > 0 ? frame[0] >> 4 : 0;
+        uint8_t paths = length > 0 ? frame[0] & 0x0F : 0;
+        printf("%10lu ms  objects %d  paths %d ",(unsigned long)time,objects,paths);
+        for(uint8_t i = 0; i < objects && 4+4*i < length; i++) printf(" o%d=%ld/%d",i,map(frame[1+4*i],0,255,0,180),frame[2+4*i]);
+        for(uint8_t i = 0; i < paths && 4+4*i < length; i++) printf(" p%d=%ld/%d",i,map(frame[3+4*i],0,255,0,180),frame[4+4*i]);
+        printf("%s\n",length == 0 ? "  (no answer)" : "");
+        fflush(stdout);
+      }
+    }
+  }
+
+  fprintf(stderr,"%lu frames, %lu damaged packets, %lu packets lost to a gap before the next keyframe\n",
+    (unsigned long)frames,(unsigned long)damaged,(unsigned long)undecodable);
+  if(logFile != 0){
+    fclose(logFile);
+    delete logPrint;
+  }
+  return 0;
+}